@@ -0,0 +1,135 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include <Kokkos_Core.hpp>
+#include <nlohmann/json.hpp>
+
+#include "Finch_Core.hpp"
+
+// Approximate floating point operations per cell for each solver (stencil
+// and update, excluding the source), used when no FP counter is available
+constexpr double ftcs_flops_per_cell = 13.0;
+constexpr double imex_flops_per_cell = 20.0;
+
+// Run the single layer time loop, measuring each phase of the step
+// separately
+template <class ExecutionSpace, class MemorySpace, class SolverType>
+void benchmark( ExecutionSpace exec_space, Finch::Inputs& db,
+                Finch::Grid<MemorySpace>& grid, Finch::MovingBeam& beam,
+                SolverType& fd, Finch::KernelProfile& profile,
+                const double flops_per_cell )
+{
+    Finch::Layer<MemorySpace> app( db, grid );
+
+    double cells = static_cast<double>( grid.getIndexSpace().size() );
+    auto measure = [&]( const std::string& phase, auto&& kernel )
+    {
+        profile.measure( exec_space, phase, cells,
+                         ( phase == "solve" ) ? flops_per_cell : 0.0,
+                         kernel );
+    };
+
+    double& time = db.time.time;
+    double dt = db.time.time_step;
+    for ( int n = 0; n < db.time.num_steps; ++n )
+        app.step( exec_space, time, dt, grid, beam, fd, measure );
+}
+
+void run( int argc, char* argv[] )
+{
+    using exec_space = Kokkos::DefaultExecutionSpace;
+    using memory_space = exec_space::memory_space;
+
+    int comm_rank;
+    MPI_Comm_rank( MPI_COMM_WORLD, &comm_rank );
+
+    const char* filename = nullptr;
+    int option;
+    while ( ( option = getopt( argc, argv, "i:" ) ) != -1 )
+    {
+        if ( option == 'i' )
+            filename = optarg;
+        else
+            throw std::runtime_error( "Error: the input file must be "
+                                      "specified using -i <input_json_file>" );
+    }
+    if ( filename == nullptr )
+        throw std::runtime_error( "Error: the input file must be "
+                                  "specified using -i <input_json_file>" );
+
+    // Standard simulation inputs, with optional benchmark settings
+    nlohmann::json config = Finch::readInputFile( filename );
+    nlohmann::json settings =
+        config.value( "benchmark", nlohmann::json::object() );
+    bool counters = settings.value( "counters", true );
+    std::uint64_t fp_event = 0;
+    if ( settings.contains( "fp_event" ) )
+        fp_event = std::stoull(
+            settings["fp_event"].get<std::string>(), nullptr, 0 );
+    double peak_bandwidth = settings.value( "peak_bandwidth", 0.0 );
+    double peak_flops = settings.value( "peak_flops", 0.0 );
+
+    Finch::Inputs db( MPI_COMM_WORLD, config );
+    if ( db.members.size > 1 ||
+         ( db.numerics.solver != "ftcs" && db.numerics.solver != "imex" ) )
+        throw std::runtime_error( "Error: the benchmark supports a single "
+                                  "member with the ftcs or imex solver" );
+
+    Finch::MovingBeam beam( db.source.scan_path_file );
+
+    std::array<std::string, 6> bc_types = { "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic" };
+    Finch::Grid<memory_space> grid(
+        MPI_COMM_WORLD, db.space.cell_size, db.space.global_low_corner,
+        db.space.global_high_corner, db.space.ranks_per_dim, bc_types,
+        db.space.initial_temperature );
+
+    // Counters are opened after Kokkos is initialized to include its threads
+    Finch::KernelProfile profile( counters, fp_event );
+    if ( db.numerics.solver == "imex" )
+    {
+        auto fd = Finch::createImexSolver( db, grid );
+        benchmark( exec_space(), db, grid, beam, fd, profile,
+                   imex_flops_per_cell );
+    }
+    else
+    {
+        auto fd = Finch::createSolver( db, grid );
+        benchmark( exec_space(), db, grid, beam, fd, profile,
+                   ftcs_flops_per_cell );
+    }
+
+    // Kernels are local: report the first rank
+    if ( comm_rank == 0 )
+        profile.write( std::cout, peak_bandwidth, peak_flops );
+}
+
+int main( int argc, char* argv[] )
+{
+    MPI_Init( &argc, &argv );
+    Kokkos::initialize( argc, argv );
+
+    run( argc, argv );
+
+    Kokkos::finalize();
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,407 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*
+  Task-farm ensemble driver: the world communicator is split into groups of
+  ranks_per_case ranks and world rank 0 dynamically hands out cases (JSON
+  deltas over a base input file) to groups as they become idle. Each case
+  runs in its own output directory.
+*/
+
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <mpi.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include "Finch_Core.hpp"
+
+// Message tags between group leaders and the coordinator.
+enum EnsembleTag
+{
+    request_tag = 1,
+    assign_tag = 2
+};
+
+// Build the full list of cases: explicit deltas followed by every point of
+// the (optional) full-factorial parameter grid.
+std::vector<nlohmann::json> createCases( const nlohmann::json& ensemble )
+{
+    nlohmann::json base = ensemble.at( "base" ).is_string()
+                              ? Finch::readInputFile( ensemble["base"] )
+                              : ensemble["base"];
+
+    std::vector<nlohmann::json> cases;
+    if ( ensemble.contains( "cases" ) )
+    {
+        for ( auto& delta : ensemble["cases"] )
+        {
+            nlohmann::json db = base;
+            db.merge_patch( delta );
+            cases.push_back( db );
+        }
+    }
+
+    if ( ensemble.contains( "parameters" ) )
+    {
+        // Parameters are given as JSON pointers into the base inputs, e.g.
+        // "/source/absorption": [0.3, 0.4]
+        std::vector<std::string> keys;
+        std::vector<nlohmann::json> values;
+        for ( auto& [key, value] : ensemble["parameters"].items() )
+        {
+            keys.push_back( key );
+            values.push_back( value );
+        }
+
+        std::vector<std::size_t> index( keys.size(), 0 );
+        bool done = keys.empty();
+        while ( !done )
+        {
+            nlohmann::json db = base;
+            for ( std::size_t p = 0; p < keys.size(); ++p )
+                db[nlohmann::json::json_pointer( keys[p] )] =
+                    values[p][index[p]];
+            cases.push_back( db );
+
+            // Advance the multi-index over the parameter grid.
+            done = true;
+            for ( std::size_t p = 0; p < keys.size(); ++p )
+            {
+                if ( ++index[p] < values[p].size() )
+                {
+                    done = false;
+                    break;
+                }
+                index[p] = 0;
+            }
+        }
+    }
+
+    return cases;
+}
+
+// Run a single case on the provided (group) communicator.
+void runCase( MPI_Comm comm, nlohmann::json db )
+{
+    using exec_space = Kokkos::DefaultExecutionSpace;
+    using memory_space = exec_space::memory_space;
+
+    // initialize the simulation
+    Finch::Inputs inputs( comm, db );
+    if ( inputs.io.enabled() )
+        throw std::runtime_error(
+            "Error: ensemble cases do not support I/O servers" );
+
+    // initialize a moving beam
+    Finch::MovingBeam beam( inputs.source.scan_path_file );
+
+    // Mesh-free evaluation only at the requested points
+    if ( inputs.numerics.solver == "greens_function" )
+    {
+        Finch::GreensFunctionLayer<memory_space> app( comm, inputs );
+        app.run( exec_space(), inputs, beam );
+        app.writeSolidificationData();
+        return;
+    }
+
+    // Define boundary condition details.
+    std::array<std::string, 6> bc_types = { "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic" };
+
+    // create the global mesh
+    Finch::Grid<memory_space> grid(
+        comm, inputs.space.cell_size, inputs.space.global_low_corner,
+        inputs.space.global_high_corner, inputs.space.ranks_per_dim, bc_types,
+        inputs.space.initial_temperature, inputs.members.size );
+
+    // Quasi-steady melt pool of the last track, without time stepping
+    if ( inputs.numerics.solver == "steady" )
+    {
+        Finch::SteadyLayer<memory_space> app( inputs, grid, beam );
+        app.run( exec_space(), inputs, grid );
+        app.writeSolidificationData();
+        return;
+    }
+
+    // Run the full single layer problem
+    Finch::Layer app( inputs, grid );
+    Finch::runLayer( exec_space(), inputs, grid, app, beam );
+
+    // Write the temperature data used by ExaCA/other post-processing
+    app.writeSolidificationData( comm );
+}
+
+// Result of a case sent to the coordinator with each request: case index,
+// group index, elapsed time in milliseconds, and status.
+using CaseResult = std::array<long, 4>;
+
+enum CaseStatus
+{
+    case_ok = 0,
+    case_failed = 1
+};
+
+// Run a single case within its own directory so that all outputs (fields and
+// solidification data) are written per case. A failing case is reported in
+// the result rather than ending the ensemble.
+CaseResult runCaseInDirectory( MPI_Comm comm, const nlohmann::json& case_db,
+                               const int case_index, const int group,
+                               const std::string& output_directory,
+                               const std::string& launch_dir )
+{
+    int comm_rank;
+    MPI_Comm_rank( comm, &comm_rank );
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::string case_dir =
+        output_directory + "/case_" + std::to_string( case_index );
+
+    int failed = 0;
+    try
+    {
+        Finch::createDirectory( comm, case_dir );
+        if ( comm_rank == 0 )
+        {
+            std::ofstream case_inputs( case_dir + "/inputs.json" );
+            case_inputs << std::setw( 2 ) << case_db << std::endl;
+        }
+
+        // Resolve inputs relative to the launch directory.
+        nlohmann::json db = case_db;
+        Finch::resolveScanPaths( db, launch_dir );
+
+        if ( chdir( case_dir.c_str() ) != 0 )
+            throw std::runtime_error( "Cannot enter directory " + case_dir );
+        runCase( comm, db );
+    }
+    catch ( std::exception& e )
+    {
+        std::cerr << "Case " << case_index << " failed: " << e.what()
+                  << std::endl;
+        failed = 1;
+    }
+    if ( chdir( launch_dir.c_str() ) != 0 )
+        throw std::runtime_error( "Cannot return to " + launch_dir );
+
+    // The case failed if it failed on any rank of the group
+    MPI_Allreduce( MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, comm );
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return { case_index, group,
+             std::chrono::duration_cast<std::chrono::milliseconds>( end -
+                                                                    start )
+                 .count(),
+             failed ? case_failed : case_ok };
+}
+
+// Summary of all cases, written by the coordinator.
+class Summary
+{
+  public:
+    Summary( const std::string& output_directory )
+        : summary_( output_directory + "/summary.csv" )
+    {
+        summary_ << "case,group,elapsed,status" << std::endl;
+    }
+
+    void record( const CaseResult& result )
+    {
+        double elapsed = result[2] * 1e-3;
+        std::string status = ( result[3] == case_ok ) ? "ok" : "failed";
+        std::cout << "Case " << result[0]
+                  << ( ( result[3] == case_ok ) ? " completed" : " failed" )
+                  << " by group " << result[1] << " in " << std::fixed
+                  << std::setprecision( 3 ) << elapsed << " seconds"
+                  << std::endl;
+        summary_ << result[0] << "," << result[1] << "," << elapsed << ","
+                 << status << std::endl;
+    }
+
+  private:
+    std::ofstream summary_;
+};
+
+// Coordinator: hand out cases to groups until all are complete.
+void coordinate( const int num_cases, const int num_groups,
+                 const std::string& output_directory )
+{
+    Summary summary( output_directory );
+
+    int next_case = 0;
+    int active_groups = num_groups;
+    while ( active_groups > 0 )
+    {
+        // Each request carries the result of the previous case (if any).
+        CaseResult result;
+        MPI_Status status;
+        MPI_Recv( result.data(), result.size(), MPI_LONG, MPI_ANY_SOURCE,
+                  request_tag, MPI_COMM_WORLD, &status );
+
+        if ( result[0] >= 0 )
+            summary.record( result );
+
+        int assigned = -1;
+        if ( next_case < num_cases )
+        {
+            assigned = next_case++;
+            std::cout << "Case " << assigned << " assigned to group "
+                      << result[1] << std::endl;
+        }
+        else
+        {
+            active_groups--;
+        }
+        MPI_Send( &assigned, 1, MPI_INT, status.MPI_SOURCE, assign_tag,
+                  MPI_COMM_WORLD );
+    }
+}
+
+// Group worker: request cases from the coordinator and run them.
+void work( MPI_Comm group_comm, const int group,
+           const std::vector<nlohmann::json>& cases,
+           const std::string& output_directory, const std::string& launch_dir,
+           const int coordinator )
+{
+    int group_rank;
+    MPI_Comm_rank( group_comm, &group_rank );
+
+    CaseResult result = { -1, group, 0, case_ok };
+    while ( true )
+    {
+        int assigned = -1;
+        if ( group_rank == 0 )
+        {
+            MPI_Send( result.data(), result.size(), MPI_LONG, coordinator,
+                      request_tag, MPI_COMM_WORLD );
+            MPI_Recv( &assigned, 1, MPI_INT, coordinator, assign_tag,
+                      MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+        }
+        MPI_Bcast( &assigned, 1, MPI_INT, 0, group_comm );
+        if ( assigned < 0 )
+            break;
+
+        result = runCaseInDirectory( group_comm, cases[assigned], assigned,
+                                     group, output_directory, launch_dir );
+    }
+}
+
+void run( int argc, char* argv[] )
+{
+    int world_rank, world_size;
+    MPI_Comm_rank( MPI_COMM_WORLD, &world_rank );
+    MPI_Comm_size( MPI_COMM_WORLD, &world_size );
+
+    const char* filename = nullptr;
+    int option;
+    while ( ( option = getopt( argc, argv, "i:" ) ) != -1 )
+    {
+        if ( option == 'i' )
+            filename = optarg;
+        else
+            throw std::runtime_error( "Error: the ensemble input file must be "
+                                      "specified using -i <input_json_file>" );
+    }
+    if ( filename == nullptr )
+        throw std::runtime_error( "Error: the ensemble input file must be "
+                                  "specified using -i <input_json_file>" );
+
+    nlohmann::json ensemble = Finch::readInputFile( filename );
+    int ranks_per_case = ensemble.value( "ranks_per_case", 1 );
+    std::string output_directory =
+        ensemble.value( "output_directory", "ensemble" );
+
+    std::vector<nlohmann::json> cases = createCases( ensemble );
+    const int num_cases = cases.size();
+
+    char cwd[PATH_MAX];
+    if ( getcwd( cwd, PATH_MAX ) == nullptr )
+        throw std::runtime_error( "Cannot determine working directory" );
+    std::string launch_dir( cwd );
+    output_directory = Finch::absolutePath( launch_dir, output_directory );
+
+    Finch::createDirectory( MPI_COMM_WORLD, output_directory );
+    if ( world_rank == 0 )
+    {
+        std::cout << "Ensemble of " << num_cases << " cases with "
+                  << ranks_per_case << " rank(s) per case" << std::endl;
+    }
+    MPI_Barrier( MPI_COMM_WORLD );
+
+    // A single rank both coordinates and computes (serially over cases).
+    if ( world_size == 1 )
+    {
+        Summary summary( output_directory );
+        MPI_Comm self;
+        MPI_Comm_dup( MPI_COMM_SELF, &self );
+        for ( int c = 0; c < num_cases; ++c )
+            summary.record( runCaseInDirectory(
+                self, cases[c], c, 0, output_directory, launch_dir ) );
+        MPI_Comm_free( &self );
+        return;
+    }
+
+    // Otherwise world rank 0 coordinates and the remaining ranks form groups.
+    // Ranks which do not fill a complete group are left idle.
+    const int num_groups = ( world_size - 1 ) / ranks_per_case;
+    if ( num_groups == 0 )
+        throw std::runtime_error(
+            "Error: ranks_per_case exceeds the number of available ranks" );
+
+    int color = MPI_UNDEFINED;
+    if ( world_rank > 0 && ( world_rank - 1 ) / ranks_per_case < num_groups )
+        color = ( world_rank - 1 ) / ranks_per_case;
+
+    MPI_Comm group_comm;
+    MPI_Comm_split( MPI_COMM_WORLD, color, world_rank, &group_comm );
+
+    if ( world_rank == 0 )
+    {
+        int idle = world_size - 1 - num_groups * ranks_per_case;
+        if ( idle > 0 )
+            std::cout << "Warning: " << idle
+                      << " rank(s) do not fill a complete group and will be "
+                         "idle"
+                      << std::endl;
+        coordinate( num_cases, num_groups, output_directory );
+    }
+    else if ( color != MPI_UNDEFINED )
+    {
+        work( group_comm, color, cases, output_directory, launch_dir, 0 );
+        MPI_Comm_free( &group_comm );
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    MPI_Init( &argc, &argv );
+    Kokkos::initialize( argc, argv );
+
+    run( argc, argv );
+
+    Kokkos::finalize();
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*
+  Parallel-in-time single layer driver: the world communicator is split into
+  time slices of parareal/ranks_per_slice ranks each, with the usual spatial
+  decomposition within each slice.
+*/
+
+#include <array>
+#include <mpi.h>
+#include <string>
+
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Core.hpp"
+
+void run( int argc, char* argv[] )
+{
+    using exec_space = Kokkos::DefaultExecutionSpace;
+    using memory_space = exec_space::memory_space;
+
+    int world_rank, world_size;
+    MPI_Comm_rank( MPI_COMM_WORLD, &world_rank );
+    MPI_Comm_size( MPI_COMM_WORLD, &world_size );
+
+    // initialize the simulation (the domain decomposition is set per slice)
+    Finch::Inputs db( MPI_COMM_WORLD, argc, argv );
+
+    int ranks_per_slice = db.parareal.ranks_per_slice;
+    if ( world_size % ranks_per_slice != 0 )
+        throw std::runtime_error( "Error: the number of ranks must be a "
+                                  "multiple of parareal/ranks_per_slice" );
+    if ( db.members.size > 1 )
+        throw std::runtime_error(
+            "Error: parareal does not support ensemble members" );
+
+    MPI_Comm slice_comm;
+    MPI_Comm_split( MPI_COMM_WORLD, world_rank / ranks_per_slice, world_rank,
+                    &slice_comm );
+
+    if ( db.space.ranks_per_dim[0] * db.space.ranks_per_dim[1] *
+             db.space.ranks_per_dim[2] !=
+         ranks_per_slice )
+        db.space.ranks_per_dim = { 0, 0, 0 };
+
+    // Define boundary condition details (the coarse propagator requires
+    // adiabatic boundaries).
+    std::array<std::string, 6> bc_types = { "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic" };
+
+    // create the global mesh for this slice
+    Finch::Grid<memory_space> grid(
+        slice_comm, db.space.cell_size, db.space.global_low_corner,
+        db.space.global_high_corner, db.space.ranks_per_dim, bc_types,
+        db.space.initial_temperature );
+
+    Finch::PararealLayer<memory_space> app( MPI_COMM_WORLD, slice_comm, db,
+                                            grid );
+    app.run( grid );
+
+    MPI_Comm_free( &slice_comm );
+}
+
+int main( int argc, char* argv[] )
+{
+    MPI_Init( &argc, &argv );
+    Kokkos::initialize( argc, argv );
+
+    run( argc, argv );
+
+    Kokkos::finalize();
+    MPI_Finalize();
+
+    return 0;
+}
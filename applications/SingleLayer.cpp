@@ -14,6 +14,7 @@
 #include <math.h>
 #include <mpi.h>
 #include <string>
+#include <vector>
 
 #include <Kokkos_Core.hpp>
 
@@ -30,6 +31,36 @@ void run( int argc, char* argv[] )
     // initialize a moving beam
     Finch::MovingBeam beam( db.source.scan_path_file );
 
+    // Mesh-free evaluation only at the requested points
+    if ( db.numerics.solver == "greens_function" )
+    {
+        Finch::GreensFunctionLayer<memory_space> app( MPI_COMM_WORLD, db );
+        app.run( exec_space(), db, beam );
+        app.writeSolidificationData();
+        return;
+    }
+
+    // Reserve ranks for output if requested (all ranks compute otherwise)
+    Finch::IOLayout io_layout( MPI_COMM_WORLD, db.io );
+    if ( io_layout.isServer() )
+    {
+        Finch::IOServer server( io_layout, db );
+        server.run();
+        return;
+    }
+    MPI_Comm comm = io_layout.computeComm();
+    if ( io_layout.enabled() )
+    {
+        // Decompose over the compute ranks only
+        int comm_size;
+        MPI_Comm_size( comm, &comm_size );
+        if ( db.space.ranks_per_dim[0] * db.space.ranks_per_dim[1] *
+                 db.space.ranks_per_dim[2] !=
+             comm_size )
+            db.space.ranks_per_dim = {
+                0, 0, ( db.numerics.solver == "imex" ) ? 1 : 0 };
+    }
+
     // Define boundary condition details.
     std::array<std::string, 6> bc_types = { "adiabatic", "adiabatic",
                                             "adiabatic", "adiabatic",
@@ -37,19 +68,30 @@ void run( int argc, char* argv[] )
 
     // create the global mesh
     Finch::Grid<memory_space> grid(
-        MPI_COMM_WORLD, db.space.cell_size, db.space.global_low_corner,
+        comm, db.space.cell_size, db.space.global_low_corner,
         db.space.global_high_corner, db.space.ranks_per_dim, bc_types,
-        db.space.initial_temperature );
+        db.space.initial_temperature, db.members.size );
 
-    // Create the solver
-    auto fd = Finch::createSolver( db, grid );
+    // Quasi-steady melt pool of the last track, without time stepping
+    if ( db.numerics.solver == "steady" )
+    {
+        Finch::SteadyLayer<memory_space> app( db, grid, beam );
+        app.run( exec_space(), db, grid );
+        app.writeSolidificationData();
+        return;
+    }
 
     // Run the full single layer problem
     Finch::Layer app( db, grid );
-    app.run( exec_space(), db, grid, beam, fd );
+    Finch::IOClient<memory_space> io_client( io_layout, db, grid,
+                                             app.solidification_data_ );
+    Finch::runLayer( exec_space(), db, grid, app, beam, io_client );
 
     // Write the temperature data used by ExaCA/other post-processing
-    app.writeSolidificationData( grid.getComm() );
+    if ( io_layout.enabled() )
+        io_client.finish();
+    else
+        app.writeSolidificationData( grid.getComm() );
     app.getLowerSolidificationDataBounds( grid.getComm() );
     app.getUpperSolidificationDataBounds( grid.getComm() );
 }
@@ -0,0 +1,402 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include "Finch_Core.hpp"
+
+// Source of case requests (one JSON object per line) and destination of the
+// replies (one JSON object per line): standard input and output, or
+// successive connections to a local UNIX socket.
+class Channel
+{
+  public:
+    Channel( const std::string& socket_path, std::streambuf* reply_buffer )
+        : socket_path_( socket_path )
+        , reply_( reply_buffer )
+    {
+        if ( socket_path_.empty() )
+            return;
+
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if ( socket_path_.size() >= sizeof( address.sun_path ) )
+            throw std::runtime_error( "Socket path too long: " +
+                                      socket_path_ );
+        std::strcpy( address.sun_path, socket_path_.c_str() );
+
+        listen_fd_ = socket( AF_UNIX, SOCK_STREAM, 0 );
+        unlink( socket_path_.c_str() );
+        if ( listen_fd_ < 0 ||
+             bind( listen_fd_, reinterpret_cast<sockaddr*>( &address ),
+                   sizeof( address ) ) != 0 ||
+             listen( listen_fd_, 1 ) != 0 )
+            throw std::runtime_error( "Cannot listen on socket " +
+                                      socket_path_ );
+    }
+
+    ~Channel()
+    {
+        if ( connection_fd_ >= 0 )
+            close( connection_fd_ );
+        if ( listen_fd_ >= 0 )
+        {
+            close( listen_fd_ );
+            unlink( socket_path_.c_str() );
+        }
+    }
+
+    // Wait for the next (non-empty) request; false at the end of the input
+    bool readLine( std::string& line )
+    {
+        if ( socket_path_.empty() )
+        {
+            while ( std::getline( std::cin, line ) )
+                if ( !line.empty() )
+                    return true;
+            return false;
+        }
+
+        while ( true )
+        {
+            auto end = buffer_.find( '\n' );
+            if ( end != std::string::npos )
+            {
+                line = buffer_.substr( 0, end );
+                buffer_.erase( 0, end + 1 );
+                if ( !line.empty() )
+                    return true;
+                continue;
+            }
+
+            // Serve one client at a time, waiting for the next one when the
+            // current connection closes
+            if ( connection_fd_ < 0 )
+            {
+                buffer_.clear();
+                connection_fd_ = accept( listen_fd_, nullptr, nullptr );
+                if ( connection_fd_ < 0 )
+                {
+                    if ( errno == EINTR )
+                        continue;
+                    return false;
+                }
+            }
+
+            char data[4096];
+            ssize_t received = recv( connection_fd_, data, sizeof( data ), 0 );
+            if ( received > 0 )
+            {
+                buffer_.append( data, received );
+            }
+            else if ( received == 0 || errno != EINTR )
+            {
+                close( connection_fd_ );
+                connection_fd_ = -1;
+
+                // A final request without a newline
+                if ( !buffer_.empty() )
+                {
+                    buffer_ += '\n';
+                }
+            }
+        }
+    }
+
+    void writeLine( const std::string& line )
+    {
+        if ( socket_path_.empty() )
+        {
+            reply_ << line << std::endl;
+            return;
+        }
+
+        std::string data = line + '\n';
+        std::size_t sent = 0;
+        while ( connection_fd_ >= 0 && sent < data.size() )
+        {
+            ssize_t n = send( connection_fd_, data.data() + sent,
+                              data.size() - sent, MSG_NOSIGNAL );
+            if ( n < 0 && errno == EINTR )
+                continue;
+            if ( n <= 0 )
+                break;
+            sent += n;
+        }
+    }
+
+  private:
+    std::string socket_path_;
+    std::ostream reply_;
+    int listen_fd_ = -1;
+    int connection_fd_ = -1;
+    std::string buffer_;
+};
+
+// Whether a case can reuse the grid allocated for the base inputs.
+bool sameGrid( const Finch::Inputs& inputs, const Finch::Inputs& base )
+{
+    return inputs.space.cell_size == base.space.cell_size &&
+           inputs.space.global_low_corner == base.space.global_low_corner &&
+           inputs.space.global_high_corner == base.space.global_high_corner &&
+           inputs.space.ranks_per_dim == base.space.ranks_per_dim &&
+           inputs.members.size == base.members.size;
+}
+
+// Run a single case on the preallocated grid and return its summary.
+template <class MemorySpace>
+nlohmann::json runCase( MPI_Comm comm, const nlohmann::json& db,
+                        const Finch::Inputs& base,
+                        Finch::Grid<MemorySpace>& grid )
+{
+    using exec_space = typename MemorySpace::execution_space;
+
+    // initialize the simulation
+    Finch::Inputs inputs( comm, db );
+    if ( inputs.numerics.solver == "greens_function" ||
+         inputs.numerics.solver == "steady" || inputs.io.enabled() )
+        throw std::runtime_error( "Error: the worker does not support the " +
+                                  inputs.numerics.solver +
+                                  " solver or I/O servers" );
+    if ( !sameGrid( inputs, base ) )
+        throw std::runtime_error(
+            "Error: cases cannot change the grid (space or members)" );
+
+    // initialize a moving beam
+    Finch::MovingBeam beam( inputs.source.scan_path_file );
+
+    // Start from the initial temperature of this case
+    grid.resetTemperature( inputs.space.initial_temperature );
+
+    // Run the full single layer problem
+    Finch::Layer app( inputs, grid );
+    Finch::runLayer( exec_space(), inputs, grid, app, beam );
+
+    // Write the temperature data used by ExaCA/other post-processing
+    app.writeSolidificationData( comm );
+
+    long local_events = 0;
+    if ( inputs.sampling.enabled )
+        local_events = app.solidification_data_.getEvents().extent( 0 );
+    long events;
+    MPI_Allreduce( &local_events, &events, 1, MPI_LONG, MPI_SUM, comm );
+
+    nlohmann::json summary;
+    summary["max_temperature"] = grid.maxTemperature();
+    summary["events"] = events;
+    if ( inputs.sampling.enabled )
+        summary["solidification_directory"] = inputs.sampling.directory_name;
+    return summary;
+}
+
+// Run one request (a JSON merge patch of the base inputs) in its own case
+// directory and return the reply.
+template <class MemorySpace>
+nlohmann::json runRequest( MPI_Comm comm, const std::string& request,
+                           const int case_index, const nlohmann::json& base_db,
+                           const Finch::Inputs& base,
+                           Finch::Grid<MemorySpace>& grid,
+                           const std::string& output_directory,
+                           const std::string& launch_dir )
+{
+    int comm_rank;
+    MPI_Comm_rank( comm, &comm_rank );
+
+    nlohmann::json reply;
+    reply["case"] = case_index;
+    try
+    {
+        nlohmann::json delta = nlohmann::json::parse( request );
+        if ( delta.value( "command", "" ) == "shutdown" )
+        {
+            reply["status"] = "shutdown";
+            return reply;
+        }
+
+        nlohmann::json db = base_db;
+        db.merge_patch( delta );
+
+        // Resolve inputs relative to the launch directory.
+        Finch::resolveScanPaths( db, launch_dir );
+
+        std::string case_dir = Finch::absolutePath(
+            launch_dir,
+            output_directory + "/case_" + std::to_string( case_index ) );
+        Finch::createDirectory( comm, case_dir );
+        if ( comm_rank == 0 )
+        {
+            std::ofstream case_inputs( case_dir + "/inputs.json" );
+            case_inputs << std::setw( 2 ) << db << std::endl;
+        }
+        MPI_Barrier( comm );
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if ( chdir( case_dir.c_str() ) != 0 )
+            throw std::runtime_error( "Cannot enter directory " + case_dir );
+        reply.update( runCase( comm, db, base, grid ) );
+        auto end = std::chrono::high_resolution_clock::now();
+
+        reply["status"] = "ok";
+        reply["elapsed"] = std::chrono::duration<double>( end - start ).count();
+        reply["output"] = case_dir;
+        if ( reply.contains( "solidification_directory" ) )
+            reply["solidification_directory"] = Finch::absolutePath(
+                case_dir,
+                reply["solidification_directory"].get<std::string>() );
+    }
+    catch ( std::exception& e )
+    {
+        reply["status"] = "error";
+        reply["message"] = e.what();
+    }
+
+    if ( chdir( launch_dir.c_str() ) != 0 )
+        throw std::runtime_error( "Cannot return to " + launch_dir );
+    return reply;
+}
+
+void run( int argc, char* argv[] )
+{
+    using exec_space = Kokkos::DefaultExecutionSpace;
+    using memory_space = exec_space::memory_space;
+
+    MPI_Comm comm = MPI_COMM_WORLD;
+    int comm_rank;
+    MPI_Comm_rank( comm, &comm_rank );
+
+    const char* filename = nullptr;
+    std::string socket_path;
+    std::string output_directory = "worker";
+    int option;
+    while ( ( option = getopt( argc, argv, "i:s:o:" ) ) != -1 )
+    {
+        if ( option == 'i' )
+            filename = optarg;
+        else if ( option == 's' )
+            socket_path = optarg;
+        else if ( option == 'o' )
+            output_directory = optarg;
+        else
+            throw std::runtime_error(
+                "Usage: finch_worker -i <input_json_file> [-s <socket_path>] "
+                "[-o <output_directory>]" );
+    }
+    if ( filename == nullptr )
+        throw std::runtime_error( "Error: the base input file must be "
+                                  "specified using -i <input_json_file>" );
+
+    // Replies use standard output when reading from standard input: all other
+    // output is sent to standard error
+    std::streambuf* stdout_buffer = std::cout.rdbuf();
+    if ( socket_path.empty() )
+        std::cout.rdbuf( std::cerr.rdbuf() );
+
+    char cwd[PATH_MAX];
+    if ( getcwd( cwd, PATH_MAX ) == nullptr )
+        throw std::runtime_error( "Cannot determine current directory" );
+    std::string launch_dir( cwd );
+
+    // Set up once: the grid is allocated for the base inputs and reused by
+    // every case
+    nlohmann::json base_db = Finch::readInputFile( filename );
+    Finch::Inputs base( comm, base_db );
+
+    std::array<std::string, 6> bc_types = { "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic",
+                                            "adiabatic", "adiabatic" };
+    Finch::Grid<memory_space> grid(
+        comm, base.space.cell_size, base.space.global_low_corner,
+        base.space.global_high_corner, base.space.ranks_per_dim, bc_types,
+        base.space.initial_temperature, base.members.size );
+
+    Finch::createDirectory( comm, output_directory );
+
+    // Rank 0 waits for requests and shares them with the other ranks
+    {
+        // Share whether the channel could be opened, so that every rank stops
+        // if it could not
+        std::unique_ptr<Channel> channel;
+        std::string error;
+        if ( comm_rank == 0 )
+        {
+            try
+            {
+                channel =
+                    std::make_unique<Channel>( socket_path, stdout_buffer );
+            }
+            catch ( std::exception& e )
+            {
+                error = e.what();
+            }
+        }
+        int opened = error.empty();
+        MPI_Bcast( &opened, 1, MPI_INT, 0, comm );
+        if ( !opened )
+            throw std::runtime_error(
+                comm_rank == 0 ? error : "Cannot open the request channel" );
+
+        for ( int case_index = 0;; ++case_index )
+        {
+            std::string request;
+            int length = -1;
+            if ( comm_rank == 0 && channel->readLine( request ) )
+                length = static_cast<int>( request.size() );
+            MPI_Bcast( &length, 1, MPI_INT, 0, comm );
+            if ( length < 0 )
+                break;
+            request.resize( length );
+            MPI_Bcast( request.data(), length, MPI_CHAR, 0, comm );
+
+            nlohmann::json reply =
+                runRequest( comm, request, case_index, base_db, base, grid,
+                            output_directory, launch_dir );
+            if ( comm_rank == 0 )
+                channel->writeLine( reply.dump() );
+            if ( reply["status"] == "shutdown" )
+                break;
+        }
+    }
+
+    std::cout.rdbuf( stdout_buffer );
+}
+
+int main( int argc, char* argv[] )
+{
+    MPI_Init( &argc, &argv );
+    Kokkos::initialize( argc, argv );
+
+    run( argc, argv );
+
+    Kokkos::finalize();
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,11 @@
+#!/bin/sh
+
+# Run from this directory
+cd ${0%/*} || exit 1
+
+# source executable
+FINCH_DIR=`pwd`/../..
+application=$FINCH_DIR/build/install/bin/finch_ensemble
+
+# run all cases, two groups of one rank each plus the coordinator
+mpirun -np 3 $application -i ensemble.json
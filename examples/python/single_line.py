@@ -0,0 +1,37 @@
+# Drive the small single line example in-process and sweep the absorption,
+# reading results directly from memory rather than output files.
+
+import json
+
+import numpy as np
+
+import finch
+
+finch.initialize()
+
+with open("../single_line/inputs_small.json") as f:
+    base = json.load(f)
+base["source"]["scan_path_file"] = "../single_line/scan_path_small.txt"
+
+for absorption in [0.3, 0.35, 0.4]:
+    base["source"]["absorption"] = absorption
+
+    inputs = finch.Inputs(base)
+    grid = finch.Grid(inputs)
+    beam = finch.MovingBeam(inputs.source.scan_path_file)
+    solver = finch.create_solver(inputs, grid)
+
+    layer = finch.Layer(inputs, grid)
+    layer.run(inputs, grid, beam, solver)
+
+    # Temperature (owned and ghost cells) and recorded solidification events
+    T = grid.temperature()
+    events = layer.events()
+    print(
+        f"absorption {absorption}: max temperature {np.max(T):.1f}, "
+        f"{events.shape[0]} solidification events"
+    )
+
+    del T, events, layer, solver, grid
+
+finch.finalize()
@@ -0,0 +1,302 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*
+  Python bindings for driving Finch in-process. Temperature and solidification
+  event arrays are exposed to NumPy without copies for host memory spaces
+  (device data is copied to the host).
+*/
+
+#include <array>
+#include <memory>
+#include <mpi.h>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <Kokkos_Core.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include "Finch_Core.hpp"
+
+namespace py = pybind11;
+
+using exec_space = Kokkos::DefaultExecutionSpace;
+using memory_space = exec_space::memory_space;
+using grid_type = Finch::Grid<memory_space>;
+using solver_type = decltype( Finch::createSolver(
+    std::declval<Finch::Inputs>(), std::declval<grid_type>() ) );
+using layer_type = Finch::Layer<memory_space>;
+
+// Convert a communicator handle from Python (e.g. mpi4py comm.py2f()),
+// defaulting to MPI_COMM_WORLD.
+MPI_Comm getComm( const py::object& comm )
+{
+    if ( comm.is_none() )
+        return MPI_COMM_WORLD;
+    return MPI_Comm_f2c( comm.cast<MPI_Fint>() );
+}
+
+// Wrap a host-accessible Kokkos view as a NumPy array without copying. The
+// array keeps a reference to the view so the allocation stays alive.
+template <class ViewType>
+py::array wrapHostView( const ViewType& view )
+{
+    using value_type = typename ViewType::non_const_value_type;
+
+    std::vector<py::ssize_t> shape( ViewType::rank );
+    std::vector<py::ssize_t> strides( ViewType::rank );
+    for ( std::size_t d = 0; d < ViewType::rank; ++d )
+    {
+        shape[d] = view.extent( d );
+        strides[d] = view.stride( d ) * sizeof( value_type );
+    }
+
+    auto owner = new ViewType( view );
+    py::capsule base( owner,
+                      []( void* v ) { delete static_cast<ViewType*>( v ); } );
+    return py::array( py::dtype::of<value_type>(), shape, strides,
+                      owner->data(), base );
+}
+
+// Return a NumPy array for any view: zero-copy on the host, otherwise a host
+// copy.
+template <class ViewType>
+py::array wrapView( const ViewType& view )
+{
+    if constexpr ( Kokkos::SpaceAccessibility<
+                       Kokkos::HostSpace,
+                       typename ViewType::memory_space>::accessible )
+    {
+        return wrapHostView( view );
+    }
+    else
+    {
+        auto view_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), view );
+        return wrapHostView( view_host );
+    }
+}
+
+// Parse a Python dictionary (JSON-compatible) into the input database.
+nlohmann::json toJson( const py::dict& inputs )
+{
+    auto json = py::module_::import( "json" );
+    std::string dumped = py::str( json.attr( "dumps" )( inputs ) );
+    return nlohmann::json::parse( dumped );
+}
+
+PYBIND11_MODULE( finch, m )
+{
+    m.doc() = "Finch: finite difference heat transfer for additive "
+              "manufacturing";
+
+    m.def(
+        "initialize",
+        []( std::vector<std::string> args )
+        {
+            int mpi_initialized;
+            MPI_Initialized( &mpi_initialized );
+            if ( !mpi_initialized )
+                MPI_Init( nullptr, nullptr );
+
+            if ( !Kokkos::is_initialized() )
+            {
+                std::vector<char*> argv;
+                for ( auto& a : args )
+                    argv.push_back( a.data() );
+                int argc = argv.size();
+                Kokkos::initialize( argc, argv.data() );
+            }
+        },
+        py::arg( "args" ) = std::vector<std::string>() );
+
+    m.def( "finalize",
+           []()
+           {
+               if ( Kokkos::is_initialized() )
+                   Kokkos::finalize();
+
+               int mpi_finalized;
+               MPI_Finalized( &mpi_finalized );
+               if ( !mpi_finalized )
+                   MPI_Finalize();
+           } );
+
+    m.def( "version", &Finch::version );
+
+    py::class_<Finch::Time>( m, "Time" )
+        .def_readwrite( "Co", &Finch::Time::Co )
+        .def_readwrite( "start_time", &Finch::Time::start_time )
+        .def_readwrite( "end_time", &Finch::Time::end_time )
+        .def_readwrite( "time_step", &Finch::Time::time_step )
+        .def_readwrite( "time", &Finch::Time::time )
+        .def_readwrite( "num_steps", &Finch::Time::num_steps );
+
+    py::class_<Finch::Space>( m, "Space" )
+        .def_readwrite( "initial_temperature",
+                        &Finch::Space::initial_temperature )
+        .def_readwrite( "cell_size", &Finch::Space::cell_size )
+        .def_readwrite( "global_low_corner", &Finch::Space::global_low_corner )
+        .def_readwrite( "global_high_corner",
+                        &Finch::Space::global_high_corner )
+        .def_readwrite( "ranks_per_dim", &Finch::Space::ranks_per_dim );
+
+    py::class_<Finch::Source>( m, "Source" )
+        .def_readwrite( "absorption", &Finch::Source::absorption )
+        .def_readwrite( "two_sigma", &Finch::Source::two_sigma )
+        .def_readwrite( "scan_path_file", &Finch::Source::scan_path_file );
+
+    py::class_<Finch::Properties>( m, "Properties" )
+        .def_readwrite( "density", &Finch::Properties::density )
+        .def_readwrite( "specific_heat", &Finch::Properties::specific_heat )
+        .def_readwrite( "thermal_conductivity",
+                        &Finch::Properties::thermal_conductivity )
+        .def_readwrite( "thermal_diffusivity",
+                        &Finch::Properties::thermal_diffusivity )
+        .def_readwrite( "latent_heat", &Finch::Properties::latent_heat )
+        .def_readwrite( "solidus", &Finch::Properties::solidus )
+        .def_readwrite( "liquidus", &Finch::Properties::liquidus );
+
+    py::class_<Finch::Inputs>( m, "Inputs" )
+        .def( py::init(
+                  []( const py::dict& inputs, const py::object& comm )
+                  { return Finch::Inputs( getComm( comm ), toJson( inputs ) ); } ),
+              py::arg( "inputs" ), py::arg( "comm" ) = py::none() )
+        .def( py::init(
+                  []( const std::string& filename, const py::object& comm )
+                  { return Finch::Inputs( getComm( comm ), filename ); } ),
+              py::arg( "filename" ), py::arg( "comm" ) = py::none() )
+        .def_readwrite( "time", &Finch::Inputs::time )
+        .def_readwrite( "space", &Finch::Inputs::space )
+        .def_readwrite( "source", &Finch::Inputs::source )
+        .def_readwrite( "properties", &Finch::Inputs::properties )
+        .def( "write", &Finch::Inputs::write );
+
+    py::class_<grid_type>( m, "Grid" )
+        .def( py::init(
+                  []( Finch::Inputs& inputs,
+                      std::array<std::string, 6> bc_types,
+                      std::optional<std::array<double, 6>> bc_values,
+                      const py::object& comm )
+                  {
+                      if ( bc_values )
+                      {
+                          Kokkos::Array<double, 6> values;
+                          for ( int b = 0; b < 6; ++b )
+                              values[b] = ( *bc_values )[b];
+                          return std::make_unique<grid_type>(
+                              getComm( comm ), inputs.space.cell_size,
+                              inputs.space.global_low_corner,
+                              inputs.space.global_high_corner,
+                              inputs.space.ranks_per_dim, bc_types, values,
+                              inputs.space.initial_temperature,
+                              inputs.members.size );
+                      }
+                      return std::make_unique<grid_type>(
+                          getComm( comm ), inputs.space.cell_size,
+                          inputs.space.global_low_corner,
+                          inputs.space.global_high_corner,
+                          inputs.space.ranks_per_dim, bc_types,
+                          inputs.space.initial_temperature,
+                          inputs.members.size );
+                  } ),
+              py::arg( "inputs" ),
+              py::arg( "bc_types" ) = std::array<std::string, 6>{
+                  "adiabatic", "adiabatic", "adiabatic", "adiabatic",
+                  "adiabatic", "adiabatic" },
+              py::arg( "bc_values" ) = py::none(),
+              py::arg( "comm" ) = py::none() )
+        .def_readonly( "comm_rank", &grid_type::comm_rank )
+        .def_readonly( "comm_size", &grid_type::comm_size )
+        .def( "temperature",
+              []( grid_type& grid ) { return wrapView( grid.getTemperature() ); },
+              "Temperature (including ghost cells) indexed as [i, j, k, "
+              "member]. On the host this aliases the current buffer, which "
+              "each step swaps with the previous one: call again after "
+              "stepping rather than keeping the array." )
+        .def(
+            "previous_temperature",
+            []( grid_type& grid )
+            { return wrapView( grid.getPreviousTemperature() ); },
+            "Temperature at the previous step, valid until the next step "
+            "(as temperature())" )
+        .def(
+            "owned_space",
+            []( grid_type& grid )
+            {
+                auto space = grid.getIndexSpace();
+                std::array<long, 3> min, max;
+                for ( int d = 0; d < 3; ++d )
+                {
+                    min[d] = space.min( d );
+                    max[d] = space.max( d );
+                }
+                return py::make_tuple( min, max );
+            },
+            "Local (min, max) indices of the owned cells" )
+        .def( "output", &grid_type::output )
+        .def( "update_boundaries", &grid_type::updateBoundaries )
+        .def( "gather", &grid_type::gather );
+
+    py::class_<Finch::MovingBeam>( m, "MovingBeam" )
+        .def( py::init<const std::string>(), py::arg( "scan_path_file" ) )
+        .def( "move", &Finch::MovingBeam::move )
+        .def( "index", &Finch::MovingBeam::index )
+        .def( "position",
+              py::overload_cast<>( &Finch::MovingBeam::position, py::const_ ) )
+        .def( "power", &Finch::MovingBeam::power );
+
+    py::class_<solver_type>( m, "Solver" );
+    m.def( "create_solver",
+           []( Finch::Inputs& inputs, grid_type& grid )
+           { return Finch::createSolver( inputs, grid ); } );
+
+    py::class_<layer_type>( m, "Layer" )
+        .def( py::init<Finch::Inputs&, grid_type&>(), py::arg( "inputs" ),
+              py::arg( "grid" ) )
+        .def(
+            "step",
+            []( layer_type& layer, double time, const double dt,
+                grid_type& grid, Finch::MovingBeam& beam, solver_type& fd )
+            {
+                layer.step( exec_space(), time, dt, grid, beam, fd );
+                return time;
+            },
+            "Run a single time step, returning the updated time" )
+        .def( "run",
+              []( layer_type& layer, Finch::Inputs& inputs, grid_type& grid,
+                  Finch::MovingBeam& beam, solver_type& fd )
+              { layer.run( exec_space(), inputs, grid, beam, fd ); } )
+        .def(
+            "solidification_data",
+            []( layer_type& layer )
+            { return wrapHostView( layer.getSolidificationData() ); },
+            "Solidification events (x, y, z, tm, ts, R, Gx, Gy, Gz), one per "
+            "row" )
+        .def(
+            "events",
+            []( layer_type& layer )
+            { return wrapView( layer.solidification_data_.getEvents() ); },
+            "Solidification events recorded so far, without copying on the "
+            "host" )
+        .def(
+            "write_solidification_data",
+            []( layer_type& layer, const py::object& comm )
+            { layer.writeSolidificationData( getComm( comm ) ); },
+            py::arg( "comm" ) = py::none() );
+}
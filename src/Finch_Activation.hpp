@@ -0,0 +1,248 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file Activation.hpp
+  \brief Material activation (element birth) for deposition processes
+*/
+
+#ifndef Activation_H
+#define Activation_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+
+namespace Finch
+{
+
+/*
+  Per-cell mask of the material deposited so far. The substrate is active
+  from the start; every step with the beam on, the cells within the bead
+  footprint (a cylinder of the bead width below the beam, one bead height
+  deep) become active, at points along the beam path since the previous step
+  at most half a bead width apart (a straight line between the step end
+  positions). The mask covers the ghost cells as well and is updated
+  identically on every rank, so no communication is needed. The bounding box
+  of the owned active cells only grows and limits the solve.
+*/
+template <class MemorySpace>
+class Activation
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using mask_type = Kokkos::View<std::uint8_t***, memory_space>;
+    using local_mesh_type = typename Grid<memory_space>::local_mesh_type;
+    using entity_type = typename Grid<memory_space>::entity_type;
+
+    // Default to disabled: all cells are active.
+    Activation()
+        : enabled_( false )
+        , previous_on_( false )
+    {
+    }
+
+    Activation( const Inputs& inputs, Grid<memory_space>& grid )
+        : enabled_( true )
+        , local_mesh_( grid.getLocalMesh() )
+        , dx_( inputs.space.cell_size )
+        , half_width_( 0.5 * inputs.deposition.bead_width )
+        , height_( inputs.deposition.bead_height )
+        , previous_on_( false )
+    {
+        auto local_grid = grid.getLocalGrid();
+        auto ghost_space = local_grid->indexSpace(
+            Cabana::Grid::Ghost(), entity_type(), Cabana::Grid::Local() );
+        auto owned_space = grid.getIndexSpace();
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            ghost_max_[d] = ghost_space.max( d );
+            owned_min_[d] = owned_space.min( d );
+            owned_max_[d] = owned_space.max( d );
+            low_corner_[d] = local_mesh_.lowCorner( Cabana::Grid::Ghost(), d );
+        }
+
+        mask_ = mask_type( "active", ghost_max_[0], ghost_max_[1],
+                           ghost_max_[2] );
+
+        // Activate the substrate (all nodes at or below its height)
+        long substrate = static_cast<long>(
+            std::floor( ( inputs.deposition.substrate_height -
+                          low_corner_[2] ) /
+                            dx_ +
+                        tolerance_ ) ) +
+                         1;
+        substrate = std::clamp( substrate, 0L, ghost_max_[2] );
+        Cabana::Grid::IndexSpace<3> substrate_space(
+            { 0, 0, 0 }, { ghost_max_[0], ghost_max_[1], substrate } );
+        auto mask = mask_;
+        Cabana::Grid::grid_parallel_for(
+            "activate_substrate", exec_space{}, substrate_space,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                mask( i, j, k ) = 1;
+            } );
+
+        for ( std::size_t d = 0; d < 2; ++d )
+        {
+            active_min_[d] = owned_min_[d];
+            active_max_[d] = owned_max_[d];
+        }
+        active_min_[2] = owned_min_[2];
+        active_max_[2] = std::clamp( substrate, owned_min_[2], owned_max_[2] );
+    }
+
+    bool enabled() const { return enabled_; }
+
+    mask_type mask() const { return mask_; }
+
+    // Owned index space bounding the active cells
+    Cabana::Grid::IndexSpace<3> space() const
+    {
+        if ( active_max_[2] <= active_min_[2] )
+            return Cabana::Grid::IndexSpace<3>( { 0, 0, 0 }, { 0, 0, 0 } );
+        return Cabana::Grid::IndexSpace<3>(
+            { active_min_[0], active_min_[1], active_min_[2] },
+            { active_max_[0], active_max_[1], active_max_[2] } );
+    }
+
+    // Activate the bead footprints along the beam path while it is on
+    void update( const double beam_pos[3], const double beam_power )
+    {
+        if ( !enabled_ )
+            return;
+        if ( beam_power <= 0.0 )
+        {
+            previous_on_ = false;
+            return;
+        }
+
+        // Points from the previous position (already activated) if the beam
+        // stayed on, so that fast beams leave no gaps
+        int num_points = 1;
+        if ( previous_on_ )
+        {
+            double distance = 0.0;
+            for ( std::size_t d = 0; d < 3; ++d )
+                distance += ( beam_pos[d] - previous_pos_[d] ) *
+                            ( beam_pos[d] - previous_pos_[d] );
+            distance = std::sqrt( distance );
+            num_points = std::max(
+                1, static_cast<int>( std::ceil( distance / half_width_ ) ) );
+        }
+        for ( int n = 1; n <= num_points; ++n )
+        {
+            double pos[3];
+            for ( std::size_t d = 0; d < 3; ++d )
+                pos[d] = ( num_points == 1 )
+                             ? beam_pos[d]
+                             : previous_pos_[d] +
+                                   ( beam_pos[d] - previous_pos_[d] ) * n /
+                                       num_points;
+            activate( pos );
+        }
+
+        previous_on_ = true;
+        for ( std::size_t d = 0; d < 3; ++d )
+            previous_pos_[d] = beam_pos[d];
+    }
+
+  protected:
+    // Activate the bead footprint below the given beam position
+    void activate( const double beam_pos[3] )
+    {
+        // Index range of the footprint bounding box (local, with ghosts)
+        double low[3] = { beam_pos[0] - half_width_, beam_pos[1] - half_width_,
+                          beam_pos[2] - height_ };
+        double high[3] = { beam_pos[0] + half_width_,
+                           beam_pos[1] + half_width_, beam_pos[2] };
+        long min[3];
+        long max[3];
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            min[d] = static_cast<long>(
+                std::ceil( ( low[d] - low_corner_[d] ) / dx_ - tolerance_ ) );
+            max[d] = static_cast<long>( std::floor(
+                         ( high[d] - low_corner_[d] ) / dx_ + tolerance_ ) ) +
+                     1;
+            min[d] = std::clamp( min[d], 0L, ghost_max_[d] );
+            max[d] = std::clamp( max[d], 0L, ghost_max_[d] );
+            if ( min[d] >= max[d] )
+                return;
+        }
+
+        Cabana::Grid::IndexSpace<3> footprint( { min[0], min[1], min[2] },
+                                               { max[0], max[1], max[2] } );
+        auto mask = mask_;
+        auto local_mesh = local_mesh_;
+        double x = beam_pos[0];
+        double y = beam_pos[1];
+        double r2 = half_width_ * half_width_ * ( 1.0 + tolerance_ );
+        Cabana::Grid::grid_parallel_for(
+            "activate_bead", exec_space{}, footprint,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                double loc[3];
+                int idx[3] = { i, j, k };
+                local_mesh.coordinates( entity_type(), idx, loc );
+                double dx = loc[0] - x;
+                double dy = loc[1] - y;
+                if ( dx * dx + dy * dy <= r2 )
+                    mask( i, j, k ) = 1;
+            } );
+
+        // Grow the owned active box (if the footprint overlaps this rank)
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            min[d] = std::max( min[d], owned_min_[d] );
+            max[d] = std::min( max[d], owned_max_[d] );
+            if ( min[d] >= max[d] )
+                return;
+        }
+        bool empty = active_max_[2] <= active_min_[2];
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            active_min_[d] = empty ? min[d] : std::min( active_min_[d], min[d] );
+            active_max_[d] = empty ? max[d] : std::max( active_max_[d], max[d] );
+        }
+    }
+
+    bool enabled_;
+    mask_type mask_;
+    local_mesh_type local_mesh_;
+
+    double dx_;
+    double half_width_;
+    double height_;
+    double low_corner_[3];
+
+    // beam position at the previous step, if it was on
+    bool previous_on_;
+    double previous_pos_[3];
+
+    long ghost_max_[3];
+    long owned_min_[3];
+    long owned_max_[3];
+    long active_min_[3];
+    long active_max_[3];
+
+    // Relative tolerance (in cells) for nodes exactly on the footprint edge
+    static constexpr double tolerance_ = 1e-6;
+};
+
+} // namespace Finch
+
+#endif
@@ -0,0 +1,141 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file Application.hpp
+  \brief Helpers shared by the Finch applications
+*/
+
+#ifndef Application_H
+#define Application_H
+
+#include <cerrno>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Finch_EnsembleSolver.hpp"
+#include "Finch_Grid.hpp"
+#include "Finch_ImexSolver.hpp"
+#include "Finch_Inputs.hpp"
+#include "Finch_Run.hpp"
+#include "Finch_Solver.hpp"
+#include "Finch_SpectralSolver.hpp"
+#include "MovingBeam/Finch_MovingBeam.hpp"
+
+namespace Finch
+{
+
+// Create a directory if it does not already exist.
+inline void createDirectory( const std::string& name )
+{
+    if ( mkdir( name.c_str(), 0777 ) == -1 && errno != EEXIST )
+        throw std::runtime_error( "Cannot create directory " + name );
+}
+
+// Create a directory on rank 0 of the communicator only. Every rank throws if
+// it could not be created, so that all ranks take the same error path.
+inline void createDirectory( MPI_Comm comm, const std::string& name )
+{
+    int comm_rank;
+    MPI_Comm_rank( comm, &comm_rank );
+
+    int created = 1;
+    if ( comm_rank == 0 )
+    {
+        try
+        {
+            createDirectory( name );
+        }
+        catch ( std::exception& )
+        {
+            created = 0;
+        }
+    }
+    MPI_Bcast( &created, 1, MPI_INT, 0, comm );
+    if ( !created )
+        throw std::runtime_error( "Cannot create directory " + name );
+}
+
+// Return an absolute version of a path relative to the launch directory.
+inline std::string absolutePath( const std::string& launch_dir,
+                                 const std::string& path )
+{
+    if ( !path.empty() && path[0] == '/' )
+        return path;
+    return launch_dir + "/" + path;
+}
+
+// Resolve the scan path files of the source and of any members relative to
+// the launch directory.
+inline void resolveScanPaths( nlohmann::json& db,
+                              const std::string& launch_dir )
+{
+    db["source"]["scan_path_file"] = absolutePath(
+        launch_dir, db["source"]["scan_path_file"].get<std::string>() );
+    if ( db.contains( "members" ) )
+        for ( auto& member : db["members"] )
+            if ( member.contains( "scan_path_file" ) )
+                member["scan_path_file"] = absolutePath(
+                    launch_dir, member["scan_path_file"].get<std::string>() );
+}
+
+// Create the time stepping solver selected by the inputs and run the full
+// single layer problem with it, passing any additional observers.
+template <typename ExecutionSpace, typename MemorySpace,
+          typename... Observers>
+void runLayer( ExecutionSpace exec_space, Inputs& inputs,
+               Grid<MemorySpace>& grid, Layer<MemorySpace>& app,
+               MovingBeam& beam, Observers&&... observers )
+{
+    if ( inputs.members.size > 1 )
+    {
+        // Each ensemble member has its own beam, sharing the grid
+        std::vector<MovingBeam> beams;
+        for ( auto& scan_path_file : inputs.members.scan_path_file )
+            beams.push_back( MovingBeam( scan_path_file ) );
+
+        auto fd = createEnsembleSolver( inputs, grid );
+        app.run( exec_space, inputs, grid, beams, fd,
+                 std::forward<Observers>( observers )... );
+    }
+    else if ( inputs.numerics.solver == "imex" )
+    {
+        // Conduction along z is implicit: only lateral stability limit
+        auto fd = createImexSolver( inputs, grid );
+        app.run( exec_space, inputs, grid, beam, fd,
+                 std::forward<Observers>( observers )... );
+    }
+    else if ( inputs.numerics.solver == "spectral" )
+    {
+        // Linear conduction advanced exactly in cosine space
+        auto fd = createSpectralSolver( inputs, grid );
+        app.run( exec_space, inputs, grid, beam, fd,
+                 std::forward<Observers>( observers )... );
+    }
+    else
+    {
+        // Create the solver
+        auto fd = createSolver( inputs, grid );
+        app.run( exec_space, inputs, grid, beam, fd,
+                 std::forward<Observers>( observers )... );
+    }
+}
+
+} // namespace Finch
+
+#endif
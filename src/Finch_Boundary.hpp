@@ -96,17 +96,34 @@ class Boundary
             KOKKOS_LAMBDA( const int b, const int i, const int j,
                            const int k ) {
                 // Corresponds to the user-passed strings set up in the
-                // constructor.
-                if ( type[b] == 0 )
-                    T( i, j, k, 0 ) = values[b];
-                else if ( type[b] == 1 )
-                    T( i, j, k, 0 ) += values[b];
-                else
-                    T( i, j, k, 0 ) = T( i - planes[b][0], j - planes[b][1],
-                                         k - planes[b][2], 0 );
+                // constructor. Applied to every component (ensemble member).
+                for ( std::size_t c = 0; c < T.extent( 3 ); ++c )
+                {
+                    if ( type[b] == 0 )
+                        T( i, j, k, c ) = values[b];
+                    else if ( type[b] == 1 )
+                        T( i, j, k, c ) += values[b];
+                    else
+                        T( i, j, k, c ) =
+                            T( i - planes[b][0], j - planes[b][1],
+                               k - planes[b][2], c );
+                }
             } );
     }
 
+    // Return the boundary type for each plane.
+    std::array<std::string, 6> getTypes() const { return boundary_types; }
+
+    // Whether any boundary updates ghost values from their previous values
+    // (rather than overwriting them).
+    bool accumulates() const
+    {
+        for ( int d = 0; d < 6; d++ )
+            if ( boundary_int[d] == 1 )
+                return true;
+        return false;
+    }
+
   protected:
     //! Boundary types for each plane.
     std::array<std::string, 6> boundary_types;
@@ -12,12 +12,25 @@
 #ifndef Finch_Core_H
 #define Finch_Core_H
 
+#include "Finch_Activation.hpp"
+#include "Finch_Application.hpp"
 #include "Finch_Boundary.hpp"
+#include "Finch_EnergyMonitor.hpp"
+#include "Finch_EnsembleSolver.hpp"
+#include "Finch_GreensFunction.hpp"
 #include "Finch_Grid.hpp"
+#include "Finch_ImexSolver.hpp"
+#include "Finch_IOServer.hpp"
 #include "Finch_Inputs.hpp"
+#include "Finch_Observers.hpp"
+#include "Finch_Parareal.hpp"
+#include "Finch_PerfCounters.hpp"
 #include "Finch_Run.hpp"
 #include "Finch_SolidificationData.hpp"
 #include "Finch_Solver.hpp"
+#include "Finch_SpectralSolver.hpp"
+#include "Finch_SteadyState.hpp"
+#include "Finch_TemperatureExporter.hpp"
 #include "MovingBeam/Finch_MovingBeam.hpp"
 #include "MovingBeam/Finch_Segment.hpp"
 
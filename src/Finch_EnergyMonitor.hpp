@@ -0,0 +1,187 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file EnergyMonitor.hpp
+  \brief Global energy balance check for the explicit solvers
+*/
+
+#ifndef EnergyMonitor_H
+#define EnergyMonitor_H
+
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include <mpi.h>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+
+namespace Finch
+{
+
+namespace Impl
+{
+template <class, class = void>
+struct HasDepositedPower : std::false_type
+{
+};
+template <class SolverType>
+struct HasDepositedPower<
+    SolverType, std::void_t<decltype( std::declval<const SolverType&>()
+                                          .depositedPower() )>>
+    : std::true_type
+{
+};
+} // namespace Impl
+
+/*
+  Accumulates the energy deposited by the source and conducted through the
+  domain boundaries every step (both summed by the solve kernel) and, every
+  monitor interval, compares their sum with the change in stored energy
+  (sensible heat plus latent heat of the liquid fraction between solidus and
+  liquidus).
+  Each node is a cell of volume dx^3. Any imbalance comes from the time
+  discretization of the latent heat (the heat capacity is taken at the start
+  of the step) or from an unstable or inaccurate step, and is reported
+  relative to the energy exchanged. Only single member runs of the FTCS and
+  IMEX solvers are checked, and only if requested.
+*/
+template <class MemorySpace>
+class EnergyMonitorObserver
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+
+    EnergyMonitorObserver( const Inputs& inputs, Grid<memory_space>& grid )
+        : monitor_interval_( inputs.time.monitor.interval )
+        , tolerance_( inputs.numerics.energy_tolerance )
+        , last_step_( -1 )
+        , deposited_( 0.0 )
+        , conducted_( 0.0 )
+    {
+        double dx = inputs.space.cell_size;
+        cell_volume_ = dx * dx * dx;
+        rho_cp_ = inputs.properties.density * inputs.properties.specific_heat;
+        rho_Lf_ = inputs.properties.density * inputs.properties.latent_heat;
+        solidus_ = inputs.properties.solidus;
+        liquidus_ = inputs.properties.liquidus;
+
+        enabled_ = inputs.numerics.energy_monitor && monitor_interval_ > 0 &&
+                   grid.numMembers() == 1;
+        if ( enabled_ )
+        {
+            double local = storedEnergy( grid );
+            MPI_Allreduce( &local, &initial_, 1, MPI_DOUBLE, MPI_SUM,
+                           grid.getComm() );
+        }
+    }
+
+    int interval() const { return enabled_ ? 1 : 0; }
+
+    template <class Context>
+    void observe( const Context& ctx )
+    {
+        using solver_type = std::decay_t<decltype( ctx.solver )>;
+        if constexpr ( Impl::HasDepositedPower<solver_type>::value )
+        {
+            int first = last_step_ + 1;
+            last_step_ = ctx.step;
+
+            deposited_ += ctx.solver.depositedPower() * ctx.dt;
+            conducted_ += ctx.solver.conductedPower() * ctx.dt;
+
+            if ( ( ctx.step + 1 ) / monitor_interval_ >
+                 first / monitor_interval_ )
+                report( ctx.grid, ctx.step );
+        }
+    }
+
+    // Stored energy (J) over the owned cells of this rank, relative to zero
+    // temperature.
+    double storedEnergy( Grid<memory_space>& grid ) const
+    {
+        auto T = grid.getTemperature();
+        double rho_cp = rho_cp_;
+        double rho_Lf = rho_Lf_;
+        double solidus = solidus_;
+        double liquidus = liquidus_;
+
+        double sum = 0.0;
+        Kokkos::Sum<double> reducer( sum );
+        Cabana::Grid::grid_parallel_reduce(
+            "stored_energy", exec_space{}, grid.getIndexSpace(),
+            KOKKOS_LAMBDA( const int i, const int j, const int k,
+                           double& result ) {
+                double x = T( i, j, k, 0 );
+                double fraction = ( x - solidus ) / ( liquidus - solidus );
+                fraction = ( fraction < 0.0 )   ? 0.0
+                           : ( fraction > 1.0 ) ? 1.0
+                                                : fraction;
+                result += rho_cp * x + rho_Lf * fraction;
+            },
+            reducer );
+
+        return sum * cell_volume_;
+    }
+
+  protected:
+    // Globalize the stored, deposited and conducted energy in one reduction
+    // and log the imbalance.
+    void report( Grid<memory_space>& grid, const int step ) const
+    {
+        double local[3] = { storedEnergy( grid ), deposited_, conducted_ };
+        double global[3];
+        MPI_Allreduce( local, global, 3, MPI_DOUBLE, MPI_SUM,
+                       grid.getComm() );
+
+        int comm_rank = grid.comm_rank;
+        double stored = global[0] - initial_;
+        double imbalance = stored - global[1] - global[2];
+        double exchanged = std::abs( global[1] ) + std::abs( global[2] );
+        double relative = ( exchanged > 0.0 ) ? imbalance / exchanged : 0.0;
+
+        Info << "Energy at step " << step << ": stored change " << stored
+             << " J, deposited " << global[1] << " J, boundary " << global[2]
+             << " J, imbalance " << 100.0 * relative << "%" << std::endl;
+        if ( std::abs( relative ) > tolerance_ )
+            Info << "Warning: energy imbalance exceeds the tolerance of "
+                 << 100.0 * tolerance_ << "%" << std::endl;
+    }
+
+    int monitor_interval_;
+    double tolerance_;
+    bool enabled_;
+
+    int last_step_;
+
+    double cell_volume_;
+    double rho_cp_;
+    double rho_Lf_;
+    double solidus_;
+    double liquidus_;
+
+    // Global stored energy at construction, and this rank's energy added by
+    // the source and through the boundaries since
+    double initial_;
+    double deposited_;
+    double conducted_;
+};
+
+} // namespace Finch
+
+#endif
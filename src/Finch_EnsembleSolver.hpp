@@ -0,0 +1,231 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file EnsembleSolver.hpp
+  \brief Heat transport solve for an ensemble of members sharing one grid
+*/
+
+#ifndef EnsembleSolver_H
+#define EnsembleSolver_H
+
+#include <vector>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+#include "Finch_Solver.hpp"
+#include "MovingBeam/Finch_MovingBeam.hpp"
+
+namespace Finch
+{
+
+struct EnsembleHostTag
+{
+};
+struct EnsembleDeviceTag
+{
+};
+
+// Each ensemble member is stored as a separate component of the temperature
+// field, with its own heat source (absorption, power, and beam path). The
+// grid geometry and index math are shared and the member loop is innermost
+// so that memory access is contiguous across the ensemble.
+template <typename ViewType, typename EntityType, typename LocalMeshType>
+class EnsembleSolver : public Solver<ViewType, EntityType, LocalMeshType>
+{
+    using base_type = Solver<ViewType, EntityType, LocalMeshType>;
+    using memory_space = typename ViewType::memory_space;
+    using view_member = Kokkos::View<double*, memory_space>;
+    using view_position = Kokkos::View<double* [3], memory_space>;
+
+  protected:
+    int num_members_;
+
+    // all members follow the same beam path
+    bool shared_path_;
+
+    // per member source parameters
+    std::vector<double> absorption_;
+    std::vector<double> power_scale_;
+
+    // per member peak intensity (including power) and beam position,
+    // updated every step
+    view_member I0_power_;
+    view_position member_position_;
+
+  public:
+    EnsembleSolver( Inputs db, LocalMeshType local_mesh )
+        : base_type( db, local_mesh )
+        , num_members_( db.members.size )
+        , absorption_( db.members.absorption )
+        , power_scale_( db.members.power_scale )
+    {
+        shared_path_ = true;
+        for ( int e = 1; e < num_members_; ++e )
+            if ( db.members.scan_path_file[e] !=
+                 db.members.scan_path_file[0] )
+                shared_path_ = false;
+
+        I0_power_ = view_member( "member_intensity", num_members_ );
+        member_position_ = view_position( "member_position", num_members_ );
+    }
+
+    // Function for temperature solve: forward time-centered space (FTCS)
+    // method for all members
+    template <class ExecSpace, class IndexSpaceType>
+    void solve( ExecSpace exec_space, IndexSpaceType owned_space, ViewType& T,
+                ViewType& T0, const std::vector<MovingBeam>& beams )
+    {
+        // Update temperature views and beam parameters for current time step
+        this->T_ = T;
+
+        this->T0_ = T0;
+
+        // Peak intensity per unit absorption, based on the shared beam shape
+        double I0_by_absorption = 2.0 / ( M_PI * Kokkos::sqrt( M_PI ) *
+                                          this->r_[0] * this->r_[1] *
+                                          this->r_[2] );
+
+        auto I0_power_host =
+            Kokkos::create_mirror_view( Kokkos::HostSpace(), I0_power_ );
+        auto position_host = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                         member_position_ );
+        for ( int e = 0; e < num_members_; ++e )
+        {
+            I0_power_host( e ) = I0_by_absorption * absorption_[e] *
+                                 power_scale_[e] * beams[e].power();
+            for ( std::size_t d = 0; d < 3; ++d )
+                position_host( e, d ) = beams[e].position( d );
+        }
+        Kokkos::deep_copy( I0_power_, I0_power_host );
+        Kokkos::deep_copy( member_position_, position_host );
+
+        // Tagged versions of temperature solver for architecture optimization
+        if constexpr ( std::is_same<memory_space, Kokkos::HostSpace>::value )
+        {
+            Cabana::Grid::grid_parallel_for( "ensemble_solve", exec_space,
+                                             owned_space, EnsembleHostTag{},
+                                             *this );
+        }
+        else
+        {
+            Cabana::Grid::grid_parallel_for( "ensemble_solve", exec_space,
+                                             owned_space, EnsembleDeviceTag{},
+                                             *this );
+        }
+    }
+
+    // Host tagged version of the ensemble temperature solver
+    KOKKOS_INLINE_FUNCTION
+    void operator()( EnsembleHostTag, const int i, const int j,
+                     const int k ) const
+    {
+        double grid_loc[3];
+        int idx[3] = { i, j, k };
+        this->local_mesh_.coordinates( EntityType(), idx, grid_loc );
+
+        double w = weight( grid_loc, 0 );
+        for ( int e = 0; e < num_members_; ++e )
+        {
+            double x = this->T0_( i, j, k, e );
+
+            double dt_by_rho_cp =
+                ( x >= this->solidus_ && x <= this->liquidus_ )
+                    ? this->dt_ / ( this->rho_cp_ + this->rho_Lf_by_dT_ )
+                    : this->dt_ / ( this->rho_cp_ );
+
+            // performance improvements on host: scoping the exponential
+            if ( !shared_path_ && e > 0 )
+                w = weight( grid_loc, e );
+            double source = ( I0_power_( e ) && w < this->w_max_ )
+                                ? I0_power_( e ) * Kokkos::exp( -w )
+                                : 0.0;
+
+            double rhs = laplacian( i, j, k, e ) + source;
+
+            this->T_( i, j, k, e ) = x + rhs * dt_by_rho_cp;
+        }
+    }
+
+    // Device tagged version of the ensemble temperature solver
+    KOKKOS_INLINE_FUNCTION
+    void operator()( EnsembleDeviceTag, const int i, const int j,
+                     const int k ) const
+    {
+        double grid_loc[3];
+        int idx[3] = { i, j, k };
+        this->local_mesh_.coordinates( EntityType(), idx, grid_loc );
+
+        double shape = Kokkos::exp( -weight( grid_loc, 0 ) );
+        for ( int e = 0; e < num_members_; ++e )
+        {
+            double x = this->T0_( i, j, k, e );
+
+            double dt_by_rho_cp =
+                this->dt_ /
+                ( this->rho_cp_ + ( x >= this->solidus_ ) *
+                                      ( x <= this->liquidus_ ) *
+                                      this->rho_Lf_by_dT_ );
+
+            if ( !shared_path_ && e > 0 )
+                shape = Kokkos::exp( -weight( grid_loc, e ) );
+
+            double rhs = laplacian( i, j, k, e ) + I0_power_( e ) * shape;
+
+            this->T_( i, j, k, e ) = x + rhs * dt_by_rho_cp;
+        }
+    }
+
+    // First-order centered space laplacian stencil for a single member
+    KOKKOS_INLINE_FUNCTION
+    auto laplacian( const int i, const int j, const int k, const int e ) const
+    {
+        return ( this->T0_( i - 1, j, k, e ) + this->T0_( i + 1, j, k, e ) +
+                 this->T0_( i, j - 1, k, e ) + this->T0_( i, j + 1, k, e ) +
+                 this->T0_( i, j, k - 1, e ) + this->T0_( i, j, k + 1, e ) -
+                 6.0 * this->T0_( i, j, k, e ) ) *
+               this->k_by_dx2_;
+    }
+
+    // Normalized weight for the gaussian source term of a single member
+    KOKKOS_INLINE_FUNCTION
+    auto weight( const double grid_loc[3], const int e ) const
+    {
+        double dist_to_beam[3];
+        dist_to_beam[0] = grid_loc[0] - member_position_( e, 0 );
+        dist_to_beam[1] = grid_loc[1] - member_position_( e, 1 );
+        dist_to_beam[2] = grid_loc[2] - member_position_( e, 2 );
+
+        return ( dist_to_beam[0] * dist_to_beam[0] * this->A_inv_[0] ) +
+               ( dist_to_beam[1] * dist_to_beam[1] * this->A_inv_[1] ) +
+               ( dist_to_beam[2] * dist_to_beam[2] * this->A_inv_[2] );
+    }
+};
+
+// Create an ensemble solver based on the grid details and simulation inputs.
+template <typename MemorySpace>
+auto createEnsembleSolver( Inputs db, Grid<MemorySpace> grid )
+{
+    using entity_type = typename Grid<MemorySpace>::entity_type;
+    using view_type = typename Grid<MemorySpace>::view_type;
+    using mesh_type = typename Grid<MemorySpace>::local_mesh_type;
+
+    auto local_mesh = grid.getLocalMesh();
+
+    return EnsembleSolver<view_type, entity_type, mesh_type>( db, local_mesh );
+}
+
+} // namespace Finch
+
+#endif
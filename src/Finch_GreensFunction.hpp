@@ -0,0 +1,623 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file GreensFunction.hpp
+  \brief Mesh-free temperature evaluation at requested points
+*/
+
+#ifndef GreensFunction_H
+#define GreensFunction_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mpi.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Inputs.hpp"
+#include "Finch_SolidificationData.hpp"
+#include "MovingBeam/Finch_MovingBeam.hpp"
+
+namespace Finch
+{
+
+/*
+  For constant properties and no latent heat, the temperature is the initial
+  temperature plus a superposition of point-source kernels over the beam
+  history. The gaussian source (variance r^2/2 per direction) convolved with
+  the heat kernel is again a gaussian, with variance r^2/2 + 2 alpha tau after
+  a delay tau. The top surface is adiabatic through an image source, which
+  doubles the deposited energy; the remaining boundaries are not represented
+  (semi-infinite domain).
+
+  The beam history is discretized with one source per time step. Before each
+  evaluation, consecutive sources are aggregated into a single source whose
+  energy, centroid and spread (added to the kernel variance) match the group,
+  as long as the spread is small relative to the kernel width. Kernels only
+  widen with age, so aggregates are kept and merged further as they age, and
+  aggregates whose peak contribution has fallen below the truncation
+  tolerance are dropped for good: each step costs O(aggregates), not
+  O(history).
+*/
+template <class MemorySpace>
+class GreensFunction
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+
+    // x, y, z
+    using view_points = Kokkos::View<double* [3], memory_space>;
+    // temperature and gradient (x, y, z)
+    using view_values = Kokkos::View<double* [4], memory_space>;
+    // x, y, z, time, energy, and extra variance (x, y, z)
+    using view_sources = Kokkos::View<double* [8], memory_space>;
+
+  protected:
+    double initial_temperature_;
+    double rho_cp_;
+    double alpha_;
+    double absorption_;
+    double variance_[3];
+    double aggregation_tolerance_;
+    double truncation_tolerance_;
+
+    // Energy-weighted moments of a group of consecutive history sources
+    struct Cluster
+    {
+        double E;
+        double Et;
+        double Ex[3];
+        double Ex2[3];
+        double t_oldest;
+        double t_newest;
+    };
+
+    // aggregated history, oldest first (host), and the sources (device)
+    std::vector<Cluster> clusters_;
+    view_sources sources_;
+    int num_sources_;
+
+  public:
+    GreensFunction( const Inputs& db )
+        : initial_temperature_( db.space.initial_temperature )
+        , absorption_( db.source.absorption )
+        , aggregation_tolerance_( db.numerics.aggregation_tolerance )
+        , truncation_tolerance_( db.numerics.truncation_tolerance )
+        , num_sources_( 0 )
+    {
+        rho_cp_ = db.properties.density * db.properties.specific_heat;
+        alpha_ = db.properties.thermal_conductivity / rho_cp_;
+
+        // r = two_sigma / sqrt(2), gaussian variance r^2 / 2
+        for ( std::size_t d = 0; d < 3; ++d )
+            variance_[d] = db.source.two_sigma[d] * db.source.two_sigma[d] / 4.0;
+
+        sources_ = view_sources( "greens_function_sources", 0 );
+    }
+
+    // Add the source for the interval ( time, time + dt ], at its midpoint.
+    void addSource( MovingBeam& beam, const double time, const double dt )
+    {
+        double midpoint = time + 0.5 * dt;
+        beam.move( midpoint );
+        if ( beam.power() > 0.0 )
+        {
+            // energy doubled by the image source above the surface
+            double energy = 2.0 * absorption_ * beam.power() * dt;
+            Cluster source;
+            source.E = energy;
+            source.Et = energy * midpoint;
+            for ( int d = 0; d < 3; ++d )
+            {
+                double x = beam.position( d );
+                source.Ex[d] = energy * x;
+                source.Ex2[d] = energy * x * x;
+            }
+            source.t_oldest = midpoint;
+            source.t_newest = midpoint;
+            clusters_.push_back( source );
+        }
+    }
+
+    // Spread of a group: the widening of the kernel over its time span, or
+    // the variance of its positions, whichever is larger
+    double spread( const Cluster& c ) const
+    {
+        double spread = 2.0 * alpha_ * ( c.t_newest - c.t_oldest );
+        for ( int d = 0; d < 3; ++d )
+        {
+            double mean = c.Ex[d] / c.E;
+            spread = std::max( spread, c.Ex2[d] / c.E - mean * mean );
+        }
+        return spread;
+    }
+
+    // Aggregate and truncate the history for evaluation at the given time.
+    int aggregate( const double time )
+    {
+        const double variance_min =
+            std::min( { variance_[0], variance_[1], variance_[2] } );
+
+        std::vector<Cluster> clusters;
+        clusters.reserve( clusters_.size() );
+        for ( const Cluster& c : clusters_ )
+        {
+            // Merge with the previous (older) group while the spread stays
+            // small relative to the narrowest kernel of the merged group
+            if ( !clusters.empty() )
+            {
+                Cluster merged = clusters.back();
+                merged.E += c.E;
+                merged.Et += c.Et;
+                for ( int d = 0; d < 3; ++d )
+                {
+                    merged.Ex[d] += c.Ex[d];
+                    merged.Ex2[d] += c.Ex2[d];
+                }
+                merged.t_newest = c.t_newest;
+
+                double sigma2_min =
+                    variance_min + 2.0 * alpha_ * ( time - merged.t_newest );
+                if ( spread( merged ) <= aggregation_tolerance_ *
+                                             aggregation_tolerance_ *
+                                             sigma2_min )
+                {
+                    clusters.back() = merged;
+                    continue;
+                }
+            }
+            clusters.push_back( c );
+        }
+
+        // Drop groups whose peak contribution is negligible (it only
+        // decreases with time)
+        clusters_.clear();
+        for ( const Cluster& c : clusters )
+        {
+            double norm = c.E / rho_cp_;
+            for ( int d = 0; d < 3; ++d )
+            {
+                double mean = c.Ex[d] / c.E;
+                double variance =
+                    std::max( c.Ex2[d] / c.E - mean * mean, 0.0 );
+                norm /= std::sqrt( 2.0 * M_PI *
+                                   ( variance_[d] + variance +
+                                     2.0 * alpha_ * ( time - c.Et / c.E ) ) );
+            }
+            if ( norm > truncation_tolerance_ )
+                clusters_.push_back( c );
+        }
+
+        num_sources_ = clusters_.size();
+        if ( sources_.extent( 0 ) < clusters_.size() )
+            Kokkos::realloc( Kokkos::WithoutInitializing, sources_,
+                             clusters_.size() );
+        auto sources_host =
+            Kokkos::create_mirror_view( Kokkos::HostSpace(), sources_ );
+        for ( int c = 0; c < num_sources_; ++c )
+        {
+            const Cluster& cluster = clusters_[c];
+            for ( int d = 0; d < 3; ++d )
+            {
+                double mean = cluster.Ex[d] / cluster.E;
+                sources_host( c, d ) = mean;
+                sources_host( c, 5 + d ) =
+                    std::max( cluster.Ex2[d] / cluster.E - mean * mean, 0.0 );
+            }
+            sources_host( c, 3 ) = cluster.Et / cluster.E;
+            sources_host( c, 4 ) = cluster.E;
+        }
+        Kokkos::deep_copy( sources_, sources_host );
+
+        return num_sources_;
+    }
+
+    // Evaluate temperature and gradient at all points for the given time,
+    // using the most recently aggregated sources.
+    void evaluate( exec_space exec, const view_points& points,
+                   const double time, view_values& values )
+    {
+        auto sources = sources_;
+        const int num_sources = num_sources_;
+        const double T_init = initial_temperature_;
+        const double rho_cp = rho_cp_;
+        const double alpha = alpha_;
+        const double variance[3] = { variance_[0], variance_[1],
+                                     variance_[2] };
+
+        Kokkos::parallel_for(
+            "greens_function_evaluate",
+            Kokkos::RangePolicy<exec_space>( exec, 0, points.extent( 0 ) ),
+            KOKKOS_LAMBDA( const int p ) {
+                double T = T_init;
+                double grad[3] = { 0.0, 0.0, 0.0 };
+                for ( int s = 0; s < num_sources; ++s )
+                {
+                    double tau = time - sources( s, 3 );
+                    double g = sources( s, 4 ) / rho_cp;
+                    double arg = 0.0;
+                    double diff[3], sigma2[3];
+                    for ( int d = 0; d < 3; ++d )
+                    {
+                        sigma2[d] =
+                            variance[d] + sources( s, 5 + d ) + 2.0 * alpha * tau;
+                        diff[d] = points( p, d ) - sources( s, d );
+                        arg += diff[d] * diff[d] / ( 2.0 * sigma2[d] );
+                        g /= Kokkos::sqrt( 2.0 * M_PI * sigma2[d] );
+                    }
+                    g *= Kokkos::exp( -arg );
+
+                    T += g;
+                    for ( int d = 0; d < 3; ++d )
+                        grad[d] -= g * diff[d] / sigma2[d];
+                }
+                values( p, 0 ) = T;
+                for ( int d = 0; d < 3; ++d )
+                    values( p, 1 + d ) = grad[d];
+            } );
+    }
+};
+
+// Run a single layer evaluating the temperature only at probes, a slice, and
+// the solidification sampling region (instead of solving on a grid). Points
+// are divided evenly among the MPI ranks.
+template <class MemorySpace>
+class GreensFunctionLayer
+{
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using gf_type = GreensFunction<memory_space>;
+    using view_points = typename gf_type::view_points;
+    using view_values = typename gf_type::view_values;
+    using view_double = Kokkos::View<double*, memory_space>;
+    using view_double2D = Kokkos::View<double**, memory_space>;
+    using view_int = Kokkos::View<int*, memory_space>;
+
+    MPI_Comm comm_;
+    int comm_rank_;
+    int comm_size_;
+
+    gf_type gf_;
+
+    // probe and slice points (gathered on rank 0 for output)
+    std::vector<std::array<double, 3>> output_points_;
+    int num_probes_;
+    bool probes_written_;
+    int output_offset_;
+    std::vector<int> output_counts_;
+    std::vector<int> output_displs_;
+    view_points output_view_;
+    view_values output_values_;
+
+    // solidification sampling region
+    bool sampling_;
+    std::string format_;
+    std::string folder_name_;
+    double liquidus_;
+    double dt_;
+    view_points region_;
+    view_values region_values_;
+    view_double region_T0_;
+    view_double tm_;
+    view_int count_;
+    view_double2D events_;
+    int capacity_;
+
+    // Split a list of points evenly among ranks.
+    void partition( const int num_points, int& offset, int& size,
+                    std::vector<int>& counts, std::vector<int>& displs )
+    {
+        counts.resize( comm_size_ );
+        displs.resize( comm_size_ );
+        for ( int r = 0; r < comm_size_; ++r )
+        {
+            counts[r] = num_points / comm_size_ +
+                        ( r < num_points % comm_size_ ? 1 : 0 );
+            displs[r] = ( r == 0 ) ? 0 : displs[r - 1] + counts[r - 1];
+        }
+        offset = displs[comm_rank_];
+        size = counts[comm_rank_];
+    }
+
+    view_points createPoints( const std::string& name,
+                              const std::vector<std::array<double, 3>>& points,
+                              const int offset, const int size )
+    {
+        view_points view( name, size );
+        auto view_host = Kokkos::create_mirror_view( Kokkos::HostSpace(), view );
+        for ( int p = 0; p < size; ++p )
+            for ( int d = 0; d < 3; ++d )
+                view_host( p, d ) = points[offset + p][d];
+        Kokkos::deep_copy( view, view_host );
+        return view;
+    }
+
+    // Grid node coordinates (matching the grid solvers) within a box.
+    std::vector<std::array<double, 3>>
+    gridPoints( const Inputs& db, std::array<double, 3> low,
+                std::array<double, 3> high )
+    {
+        double dx = db.space.cell_size;
+        std::array<int, 3> min, max;
+        for ( int d = 0; d < 3; ++d )
+        {
+            double origin = db.space.global_low_corner[d];
+            int num_nodes = std::round(
+                ( db.space.global_high_corner[d] - origin ) / dx );
+            min[d] = std::max( 0, (int)std::ceil( ( low[d] - origin ) / dx -
+                                                  1e-6 ) );
+            max[d] = std::min(
+                num_nodes, (int)std::floor( ( high[d] - origin ) / dx + 1e-6 ) );
+        }
+
+        std::vector<std::array<double, 3>> points;
+        for ( int i = min[0]; i <= max[0]; ++i )
+            for ( int j = min[1]; j <= max[1]; ++j )
+                for ( int k = min[2]; k <= max[2]; ++k )
+                    points.push_back(
+                        { db.space.global_low_corner[0] + i * dx,
+                          db.space.global_low_corner[1] + j * dx,
+                          db.space.global_low_corner[2] + k * dx } );
+        return points;
+    }
+
+  public:
+    GreensFunctionLayer( MPI_Comm comm, const Inputs& db )
+        : comm_( comm )
+        , gf_( db )
+        , probes_written_( false )
+        , sampling_( db.sampling.enabled )
+        , format_( db.sampling.format )
+        , folder_name_( db.sampling.directory_name )
+        , liquidus_( db.properties.liquidus )
+        , dt_( db.time.time_step )
+    {
+        MPI_Comm_rank( comm_, &comm_rank_ );
+        MPI_Comm_size( comm_, &comm_size_ );
+
+        // Probes followed by the slice (nearest grid plane)
+        output_points_ = db.probes.points;
+        num_probes_ = output_points_.size();
+        if ( db.probes.slice )
+        {
+            auto low = db.space.global_low_corner;
+            auto high = db.space.global_high_corner;
+            int a = db.probes.slice_axis;
+            double dx = db.space.cell_size;
+            double plane =
+                low[a] +
+                std::round( ( db.probes.slice_position - low[a] ) / dx ) * dx;
+            low[a] = plane;
+            high[a] = plane;
+            auto slice = gridPoints( db, low, high );
+            output_points_.insert( output_points_.end(), slice.begin(),
+                                   slice.end() );
+        }
+        int output_size;
+        partition( output_points_.size(), output_offset_, output_size,
+                   output_counts_, output_displs_ );
+        output_view_ = createPoints( "output_points", output_points_,
+                                     output_offset_, output_size );
+        output_values_ = view_values( "output_values", output_size );
+
+        // Solidification sampling region
+        int region_offset = 0, region_size = 0;
+        if ( sampling_ )
+        {
+            auto region = gridPoints( db, db.probes.region_low_corner,
+                                      db.probes.region_high_corner );
+            std::vector<int> counts, displs;
+            partition( region.size(), region_offset, region_size, counts,
+                       displs );
+            region_ = createPoints( "region_points", region, region_offset,
+                                    region_size );
+        }
+        region_values_ = view_values( "region_values", region_size );
+        region_T0_ = view_double( "region_T0", region_size );
+        tm_ = view_double( "region_tm", region_size );
+        Kokkos::deep_copy( region_T0_, db.space.initial_temperature );
+
+        count_ = view_int( "count", 1 );
+        capacity_ = std::max( region_size, 1 );
+        events_ = view_double2D(
+            Kokkos::ViewAllocateWithoutInitializing( "events" ), capacity_, 9 );
+    }
+
+    // Run the full timestepped loop: one history source per step, with the
+    // sampling region evaluated every step and the probes and slice at the
+    // output interval.
+    void run( exec_space exec, Inputs& inputs, MovingBeam& beam )
+    {
+        double& time = inputs.time.time;
+        int num_steps = inputs.time.num_steps;
+        double dt = inputs.time.time_step;
+        int output_interval = inputs.time.output.interval;
+
+        for ( int n = 0; n < num_steps; ++n )
+        {
+            inputs.time_monitor.update();
+
+            gf_.addSource( beam, time, dt );
+            time += dt;
+
+            bool output = ( ( n + 1 ) % output_interval == 0 );
+            if ( sampling_ || output )
+                gf_.aggregate( time );
+
+            if ( sampling_ )
+            {
+                gf_.evaluate( exec, region_, time, region_values_ );
+                updateEvents( exec, time );
+            }
+
+            if ( ( n + 1 ) % inputs.time.monitor.interval == 0 )
+            {
+                inputs.time_monitor.write( n );
+            }
+
+            if ( output )
+            {
+                gf_.evaluate( exec, output_view_, time, output_values_ );
+                writeOutput( n, time );
+            }
+        }
+    }
+
+    // Record liquidus crossings in the sampling region, growing the event
+    // storage as needed.
+    void updateEvents( exec_space exec, const double time )
+    {
+        auto count_old_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), count_ );
+        recordEvents( exec, time );
+        auto count_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), count_ );
+        if ( count_host( 0 ) >= capacity_ )
+        {
+            capacity_ = 2 * count_host( 0 );
+            Kokkos::resize( Kokkos::WithoutInitializing, events_, capacity_,
+                            9 );
+            Kokkos::deep_copy( count_, count_old_host( 0 ) );
+            recordEvents( exec, time );
+        }
+
+        // store the current temperature for the next step
+        auto T0 = region_T0_;
+        auto values = region_values_;
+        Kokkos::parallel_for(
+            "greens_function_store",
+            Kokkos::RangePolicy<exec_space>( exec, 0, T0.extent( 0 ) ),
+            KOKKOS_LAMBDA( const int p ) { T0( p ) = values( p, 0 ); } );
+    }
+
+    void recordEvents( exec_space exec, const double time )
+    {
+        auto points = region_;
+        auto values = region_values_;
+        auto T0 = region_T0_;
+        auto tm = tm_;
+        auto count = count_;
+        auto events = events_;
+        const int capacity = capacity_;
+        const double liquidus = liquidus_;
+        const double dt = dt_;
+
+        Kokkos::parallel_for(
+            "greens_function_events",
+            Kokkos::RangePolicy<exec_space>( exec, 0, T0.extent( 0 ) ),
+            KOKKOS_LAMBDA( const int p ) {
+                double temp = values( p, 0 );
+                double temp0 = T0( p );
+                double m = ( temp - liquidus ) / ( temp - temp0 );
+                m = fmin( fmax( m, 0.0 ), 1.0 );
+                if ( ( temp <= liquidus ) && ( temp0 > liquidus ) )
+                {
+                    int current_count = Kokkos::atomic_fetch_add( &count( 0 ), 1 );
+                    if ( current_count < capacity )
+                    {
+                        for ( int d = 0; d < 3; ++d )
+                            events( current_count, d ) = points( p, d );
+                        events( current_count, 3 ) = tm( p );
+                        events( current_count, 4 ) = time - m * dt;
+                        events( current_count, 5 ) = ( temp0 - temp ) / dt;
+                        for ( int d = 0; d < 3; ++d )
+                            events( current_count, 6 + d ) = values( p, 1 + d );
+                    }
+                }
+                else if ( ( temp > liquidus ) && ( temp0 <= liquidus ) )
+                {
+                    tm( p ) = time - m * dt;
+                }
+            } );
+    }
+
+    // Write probe temperatures (appended as rows) and the slice to rank 0.
+    void writeOutput( const int step, const double time )
+    {
+        auto values_host = Kokkos::create_mirror_view_and_copy(
+            Kokkos::HostSpace(), output_values_ );
+        std::vector<double> local( values_host.extent( 0 ) );
+        for ( std::size_t p = 0; p < local.size(); ++p )
+            local[p] = values_host( p, 0 );
+
+        std::vector<double> global( output_points_.size() );
+        MPI_Gatherv( local.data(), local.size(), MPI_DOUBLE, global.data(),
+                     output_counts_.data(), output_displs_.data(), MPI_DOUBLE,
+                     0, comm_ );
+        if ( comm_rank_ != 0 )
+            return;
+
+        if ( num_probes_ > 0 )
+        {
+            std::ofstream fout( "probes.csv", probes_written_
+                                                  ? std::ios::app
+                                                  : std::ios::out );
+            if ( !probes_written_ )
+            {
+                fout << "time";
+                for ( int p = 0; p < num_probes_; ++p )
+                    fout << ",probe_" << p;
+                fout << std::endl;
+                probes_written_ = true;
+            }
+            fout << std::setprecision( 10 ) << time;
+            for ( int p = 0; p < num_probes_; ++p )
+                fout << "," << global[p];
+            fout << std::endl;
+        }
+
+        if ( output_points_.size() > static_cast<std::size_t>( num_probes_ ) )
+        {
+            std::ofstream fout( "slice_" + std::to_string( step ) + ".csv" );
+            fout << std::fixed << std::setprecision( 10 );
+            for ( std::size_t p = num_probes_; p < output_points_.size(); ++p )
+                fout << output_points_[p][0] << "," << output_points_[p][1]
+                     << "," << output_points_[p][2] << "," << global[p]
+                     << std::endl;
+        }
+    }
+
+    // Write the solidification data to separate files for each MPI rank,
+    // in the same format as the grid solvers.
+    void writeSolidificationData()
+    {
+        if ( !sampling_ )
+            return;
+
+        auto events_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), events_ );
+        auto count_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), count_ );
+
+        if ( mkdir( folder_name_.c_str(), 0777 ) != -1 )
+            std::cout << "Creating directory: " << folder_name_ << std::endl;
+
+        std::ofstream fout( folder_name_ + "/data_" +
+                            std::to_string( comm_rank_ ) + ".csv" );
+        fout << std::fixed << std::setprecision( 10 );
+        writeEvents( fout, events_host, count_host( 0 ), format_, 1 );
+    }
+};
+
+} // namespace Finch
+
+#endif
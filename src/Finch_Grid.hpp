@@ -17,6 +17,9 @@
 #ifndef Grid_H
 #define Grid_H
 
+#include <iostream>
+#include <utility>
+
 #include <Cabana_Grid.hpp>
 #include <Kokkos_Core.hpp>
 
@@ -56,11 +59,12 @@ class Grid
           std::array<double, 3> global_low_corner,
           std::array<double, 3> global_high_corner,
           std::array<int, 3> ranks_per_dim, std::array<std::string, 6> bc_types,
-          Kokkos::Array<double, 6> bc_values, const double initial_temperature )
+          Kokkos::Array<double, 6> bc_values, const double initial_temperature,
+          const int num_members = 1 )
         : boundary( Boundary( bc_types, bc_values ) )
     {
         initialize( comm, cell_size, global_low_corner, global_high_corner,
-                    ranks_per_dim, initial_temperature );
+                    ranks_per_dim, initial_temperature, num_members );
 
         // Create boundaries
         boundary.create( local_grid, entity_type{} );
@@ -75,11 +79,11 @@ class Grid
           std::array<double, 3> global_low_corner,
           std::array<double, 3> global_high_corner,
           std::array<int, 3> ranks_per_dim, std::array<std::string, 6> bc_types,
-          const double initial_temperature )
+          const double initial_temperature, const int num_members = 1 )
         : boundary( Boundary( bc_types ) )
     {
         initialize( comm, cell_size, global_low_corner, global_high_corner,
-                    ranks_per_dim, initial_temperature );
+                    ranks_per_dim, initial_temperature, num_members );
 
         // Create boundaries
         boundary.create( local_grid, entity_type{} );
@@ -93,7 +97,8 @@ class Grid
                      std::array<double, 3> global_low_corner,
                      std::array<double, 3> global_high_corner,
                      std::array<int, 3> ranks_per_dim,
-                     const double initial_temperature )
+                     const double initial_temperature,
+                     const int num_members = 1 )
     {
         // set up block decomposition
         MPI_Comm_size( comm, &comm_size );
@@ -122,9 +127,10 @@ class Grid
         // create a local grid and local mesh with halo region
         local_grid = Cabana::Grid::createLocalGrid( global_grid, halo_width );
 
-        // create layout for finite difference calculations
-        auto layout =
-            createArrayLayout( global_grid, halo_width, 1, entity_type() );
+        // create layout for finite difference calculations, with one
+        // component per ensemble member
+        auto layout = createArrayLayout( global_grid, halo_width, num_members,
+                                         entity_type() );
 
         std::string name( "temperature" );
         T = Cabana::Grid::createArray<double, memory_space>( name, layout );
@@ -134,6 +140,8 @@ class Grid
         // create an array to store previous temperature for explicit update
         // Note: this is an entirely separate array on purpose (no shallow copy)
         T0 = Cabana::Grid::createArray<double, memory_space>( name, layout );
+        Cabana::Grid::ArrayOp::assign( *T0, initial_temperature,
+                                       Cabana::Grid::Ghost() );
 
         // create halo
         halo = createHalo( Cabana::Grid::FaceHaloPattern<3>(), halo_width, *T );
@@ -156,6 +164,37 @@ class Grid
 
     auto getPreviousTemperature() { return T0->view(); }
 
+    // Overwrite the temperature (including ghost cells) from a stored state
+    void setTemperature( const view_type& T_state )
+    {
+        Kokkos::deep_copy( T->view(), T_state );
+    }
+
+    // Reset the current and previous temperature (including ghost cells) to
+    // a uniform value, e.g. to run a new case on the same grid
+    void resetTemperature( const double initial_temperature )
+    {
+        Cabana::Grid::ArrayOp::assign( *T, initial_temperature,
+                                       Cabana::Grid::Ghost() );
+        Cabana::Grid::ArrayOp::assign( *T0, initial_temperature,
+                                       Cabana::Grid::Ghost() );
+    }
+
+    // Make the current temperature the previous temperature for the next
+    // explicit update. The solvers only write owned cells from the previous
+    // values, so the buffers are exchanged rather than copied (and the views
+    // returned by getTemperature() alternate between the two buffers). Ghost
+    // values are kept when a boundary condition accumulates into them.
+    void swapTemperature()
+    {
+        std::swap( T, T0 );
+        if ( boundary.accumulates() )
+            Kokkos::deep_copy( T->view(), T0->view() );
+    }
+
+    // Number of ensemble members (temperature components)
+    int numMembers() { return T->layout()->dofsPerEntity(); }
+
     void output( const int step, const double time )
     {
         Cabana::Grid::Experimental::BovWriter::writeTimeStep( step, time, *T );
@@ -169,6 +208,30 @@ class Grid
 
     void gather() { halo->gather( exec_space{}, *T ); }
 
+    auto getBoundaryTypes() { return boundary.getTypes(); }
+
+    // Global maximum temperature over the owned cells (all members)
+    double maxTemperature()
+    {
+        auto T_view = getTemperature();
+        double local_max = 0.0;
+        Kokkos::Max<double> reducer( local_max );
+        Cabana::Grid::grid_parallel_reduce(
+            "max_temperature", exec_space{}, getIndexSpace(),
+            KOKKOS_LAMBDA( const int i, const int j, const int k,
+                           double& max ) {
+                for ( std::size_t c = 0; c < T_view.extent( 3 ); ++c )
+                    if ( T_view( i, j, k, c ) > max )
+                        max = T_view( i, j, k, c );
+            },
+            reducer );
+
+        double global_max;
+        MPI_Allreduce( &local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX,
+                       getComm() );
+        return global_max;
+    }
+
     MPI_Comm getComm() { return local_grid->globalGrid().comm(); }
 
   protected:
@@ -0,0 +1,625 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file IOServer.hpp
+  \brief Ranks dedicated to aggregating and writing the output
+*/
+
+#ifndef IOServer_H
+#define IOServer_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mpi.h>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <vector>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include <Finch_Core_Config.hpp>
+#ifdef Finch_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+#include "Finch_SolidificationData.hpp"
+
+namespace Finch
+{
+
+/*
+  With I/O servers the last ranks of the job (or of each node) do not compute.
+  Compute ranks send new solidification events and temperature field
+  snapshots to their server with non-blocking sends and continue stepping.
+  Each server collects the events of its compute ranks into a single file and
+  the servers write each field snapshot together into one BOV file.
+*/
+namespace IOTag
+{
+enum : int
+{
+    events = 1,
+    field = 2,
+    done = 3
+};
+} // namespace IOTag
+
+// Field snapshot message: header followed by the owned temperatures ordered
+// as (k, j, i, member).
+namespace IOFieldHeader
+{
+enum : int
+{
+    step = 0,
+    time = 1,
+    offset = 2,
+    extent = 5,
+    members = 8,
+    global_extent = 9,
+    low_corner = 12,
+    cell_size = 15,
+    size = 16
+};
+} // namespace IOFieldHeader
+
+// Assignment of ranks to computation or I/O.
+class IOLayout
+{
+  public:
+    IOLayout( MPI_Comm world, const IO& io )
+        : enabled_( io.enabled() )
+        , is_server_( false )
+        , server_( -1 )
+        , server_index_( -1 )
+        , num_clients_( 0 )
+        , compute_comm_( world )
+        , server_comm_( MPI_COMM_NULL )
+        , io_comm_( MPI_COMM_NULL )
+    {
+        if ( !enabled_ )
+            return;
+
+        // Group of ranks sharing servers: each node, or the whole job
+        MPI_Comm group;
+        int num_servers;
+        if ( io.servers_per_node > 0 )
+        {
+            MPI_Comm_split_type( world, MPI_COMM_TYPE_SHARED, 0,
+                                 MPI_INFO_NULL, &group );
+            num_servers = io.servers_per_node;
+        }
+        else
+        {
+            MPI_Comm_dup( world, &group );
+            num_servers = io.server_ranks;
+        }
+        int world_rank, group_rank, group_size;
+        MPI_Comm_rank( world, &world_rank );
+        MPI_Comm_rank( group, &group_rank );
+        MPI_Comm_size( group, &group_size );
+
+        int num_compute = group_size - num_servers;
+        if ( num_compute < num_servers )
+            throw std::runtime_error(
+                "Each I/O server requires at least one compute rank" );
+
+        // The last ranks of the group are servers; compute rank c of the group
+        // sends to server c % num_servers.
+        std::vector<int> world_ranks( group_size );
+        MPI_Allgather( &world_rank, 1, MPI_INT, world_ranks.data(), 1, MPI_INT,
+                       group );
+        is_server_ = ( group_rank >= num_compute );
+        if ( is_server_ )
+        {
+            int s = group_rank - num_compute;
+            num_clients_ = num_compute / num_servers +
+                           ( ( s < num_compute % num_servers ) ? 1 : 0 );
+        }
+        else
+        {
+            server_ = world_ranks[num_compute + group_rank % num_servers];
+        }
+        MPI_Comm_free( &group );
+
+        MPI_Comm split;
+        MPI_Comm_split( world, is_server_ ? 1 : 0, world_rank, &split );
+        if ( is_server_ )
+        {
+            compute_comm_ = MPI_COMM_NULL;
+            server_comm_ = split;
+            MPI_Comm_rank( server_comm_, &server_index_ );
+        }
+        else
+        {
+            compute_comm_ = split;
+        }
+
+        // Separate context for output messages
+        MPI_Comm_dup( world, &io_comm_ );
+    }
+
+    bool enabled() const { return enabled_; }
+    bool isServer() const { return is_server_; }
+
+    // World rank of the server for this compute rank
+    int server() const { return server_; }
+    // Index of this server among all servers
+    int serverIndex() const { return server_index_; }
+    // Number of compute ranks sending to this server
+    int numClients() const { return num_clients_; }
+
+    MPI_Comm computeComm() const { return compute_comm_; }
+    MPI_Comm serverComm() const { return server_comm_; }
+    MPI_Comm ioComm() const { return io_comm_; }
+
+  private:
+    bool enabled_;
+    bool is_server_;
+    int server_;
+    int server_index_;
+    int num_clients_;
+    MPI_Comm compute_comm_;
+    MPI_Comm server_comm_;
+    MPI_Comm io_comm_;
+};
+
+// Compute rank side: ships output to the server (as an observer of the time
+// loop) without waiting for it to be written.
+template <class MemorySpace>
+class IOClient
+{
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using grid_type = Grid<memory_space>;
+    using sampling_type = SolidificationData<memory_space>;
+    using host_view_type =
+        Kokkos::View<double**, Kokkos::LayoutRight, Kokkos::HostSpace,
+                     Kokkos::MemoryUnmanaged>;
+    using host_field_type =
+        Kokkos::View<double****, Kokkos::LayoutRight, Kokkos::HostSpace,
+                     Kokkos::MemoryUnmanaged>;
+
+    struct Message
+    {
+        std::vector<double> buffer;
+        MPI_Request request;
+    };
+
+    bool enabled_;
+    MPI_Comm io_comm_;
+    int server_;
+    int interval_;
+    int output_interval_;
+    double dt_;
+    sampling_type* data_;
+    int num_sent_;
+    int last_step_;
+    std::vector<Message> pending_;
+
+    // Field metadata (header without step and time)
+    std::array<double, IOFieldHeader::size> header_;
+
+    void send( std::vector<double>&& buffer, const int tag )
+    {
+        pending_.push_back( Message{ std::move( buffer ), MPI_REQUEST_NULL } );
+        auto& message = pending_.back();
+        MPI_Isend( message.buffer.data(), message.buffer.size(), MPI_DOUBLE,
+                   server_, tag, io_comm_, &message.request );
+    }
+
+    // Release the buffers of completed sends
+    void progress()
+    {
+        pending_.erase( std::remove_if( pending_.begin(), pending_.end(),
+                                        []( Message& message )
+                                        {
+                                            int complete;
+                                            MPI_Test( &message.request,
+                                                      &complete,
+                                                      MPI_STATUS_IGNORE );
+                                            return complete;
+                                        } ),
+                        pending_.end() );
+    }
+
+  public:
+    IOClient( const IOLayout& layout, const Inputs& inputs, grid_type& grid,
+              sampling_type& data )
+        : enabled_( layout.enabled() )
+        , io_comm_( layout.ioComm() )
+        , server_( layout.server() )
+        , interval_( inputs.io.interval )
+        , output_interval_( inputs.time.output.interval )
+        , dt_( inputs.time.time_step )
+        , data_( &data )
+        , num_sent_( 0 )
+        , last_step_( -1 )
+    {
+        auto local_grid = grid.getLocalGrid();
+        auto global_space = local_grid->indexSpace(
+            Cabana::Grid::Own(), Cabana::Grid::Node(), Cabana::Grid::Global() );
+        const auto& global_grid = local_grid->globalGrid();
+        const auto& global_mesh = global_grid.globalMesh();
+        header_.fill( 0.0 );
+        for ( int d = 0; d < 3; ++d )
+        {
+            header_[IOFieldHeader::offset + d] = global_space.min( d );
+            header_[IOFieldHeader::extent + d] = global_space.extent( d );
+            header_[IOFieldHeader::global_extent + d] =
+                global_grid.globalNumEntity( Cabana::Grid::Node(), d );
+            header_[IOFieldHeader::low_corner + d] = global_mesh.lowCorner( d );
+        }
+        header_[IOFieldHeader::members] = grid.numMembers();
+        header_[IOFieldHeader::cell_size] = global_mesh.cellSize( 0 );
+    }
+
+    int interval() const { return enabled_ ? 1 : 0; }
+
+    template <class Context>
+    void observe( const Context& ctx )
+    {
+        int first = last_step_ + 1;
+        last_step_ = ctx.step;
+        if ( ( ctx.step + 1 ) / interval_ > first / interval_ )
+            sendEvents();
+        if ( ( ctx.step + 1 ) / output_interval_ > first / output_interval_ )
+            sendField( ctx.grid, ctx.step, ctx.step * dt_ );
+        progress();
+    }
+
+    // Send the events recorded since the last call.
+    void sendEvents()
+    {
+        auto events = data_->getEvents();
+        int num_events = events.extent( 0 );
+        int num_cmpts = events.extent( 1 );
+        int num_new = num_events - num_sent_;
+        if ( num_new <= 0 )
+            return;
+
+        // Contiguous rows on the device, then on the host
+        Kokkos::View<double**, Kokkos::LayoutRight, memory_space> packed(
+            Kokkos::ViewAllocateWithoutInitializing( "io_events" ), num_new,
+            num_cmpts );
+        Kokkos::deep_copy(
+            packed, Kokkos::subview(
+                        events, Kokkos::make_pair( num_sent_, num_events ),
+                        Kokkos::ALL() ) );
+        std::vector<double> buffer( num_new * num_cmpts );
+        Kokkos::deep_copy( host_view_type( buffer.data(), num_new, num_cmpts ),
+                           packed );
+        num_sent_ = num_events;
+
+        send( std::move( buffer ), IOTag::events );
+    }
+
+    // Send the owned temperature field.
+    void sendField( grid_type& grid, const int step, const double time )
+    {
+        auto T = grid.getTemperature();
+        auto owned_space = grid.getIndexSpace();
+        int nx = owned_space.extent( 0 );
+        int ny = owned_space.extent( 1 );
+        int nz = owned_space.extent( 2 );
+        int nc = T.extent( 3 );
+        int i0 = owned_space.min( 0 );
+        int j0 = owned_space.min( 1 );
+        int k0 = owned_space.min( 2 );
+
+        Kokkos::View<double****, Kokkos::LayoutRight, memory_space> packed(
+            Kokkos::ViewAllocateWithoutInitializing( "io_field" ), nz, ny, nx,
+            nc );
+        Cabana::Grid::grid_parallel_for(
+            "io_pack_field", exec_space(), owned_space,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                for ( int c = 0; c < nc; ++c )
+                    packed( k - k0, j - j0, i - i0, c ) = T( i, j, k, c );
+            } );
+
+        std::vector<double> buffer( IOFieldHeader::size +
+                                    packed.size() );
+        std::copy( header_.begin(), header_.end(), buffer.begin() );
+        buffer[IOFieldHeader::step] = step;
+        buffer[IOFieldHeader::time] = time;
+        Kokkos::deep_copy(
+            host_field_type( buffer.data() + IOFieldHeader::size, nz, ny, nx,
+                             nc ),
+            packed );
+
+        send( std::move( buffer ), IOTag::field );
+    }
+
+    // Send the remaining events and wait for all output to be received.
+    void finish()
+    {
+        if ( !enabled_ )
+            return;
+
+        sendEvents();
+        send( std::vector<double>(), IOTag::done );
+        for ( auto& message : pending_ )
+            MPI_Wait( &message.request, MPI_STATUS_IGNORE );
+        pending_.clear();
+    }
+};
+
+// Server side: receive from the compute ranks until they are done, writing
+// field snapshots as they complete and all events at the end.
+class IOServer
+{
+    // Field blocks received for one output step
+    using field_blocks = std::vector<std::vector<double>>;
+
+    MPI_Comm io_comm_;
+    MPI_Comm server_comm_;
+    int server_index_;
+    int num_clients_;
+
+    bool sampling_enabled_;
+    std::string folder_name_;
+    std::string format_;
+    int num_members_;
+    int num_cmpts_;
+    bool sort_;
+    bool compress_;
+
+    std::vector<double> events_;
+    std::map<int, field_blocks> fields_;
+
+  public:
+    IOServer( const IOLayout& layout, const Inputs& inputs )
+        : io_comm_( layout.ioComm() )
+        , server_comm_( layout.serverComm() )
+        , server_index_( layout.serverIndex() )
+        , num_clients_( layout.numClients() )
+        , sampling_enabled_( inputs.sampling.enabled )
+        , folder_name_( inputs.sampling.directory_name )
+        , format_( inputs.sampling.format )
+        , num_members_( inputs.members.size )
+        , num_cmpts_( ( inputs.members.size > 1 ) ? 10 : 9 )
+        , sort_( inputs.io.sort )
+        , compress_( inputs.io.compress )
+    {
+    }
+
+    void run()
+    {
+        int num_done = 0;
+        while ( num_done < num_clients_ )
+        {
+            MPI_Status status;
+            MPI_Probe( MPI_ANY_SOURCE, MPI_ANY_TAG, io_comm_, &status );
+            int count;
+            MPI_Get_count( &status, MPI_DOUBLE, &count );
+            std::vector<double> buffer( count );
+            MPI_Recv( buffer.data(), count, MPI_DOUBLE, status.MPI_SOURCE,
+                      status.MPI_TAG, io_comm_, MPI_STATUS_IGNORE );
+
+            if ( status.MPI_TAG == IOTag::events )
+            {
+                events_.insert( events_.end(), buffer.begin(), buffer.end() );
+            }
+            else if ( status.MPI_TAG == IOTag::field )
+            {
+                // Compute ranks send steps in order, so each step completes
+                // on all servers in the same order
+                int step = buffer[IOFieldHeader::step];
+                auto& blocks = fields_[step];
+                blocks.push_back( std::move( buffer ) );
+                if ( static_cast<int>( blocks.size() ) == num_clients_ )
+                {
+                    writeField( blocks );
+                    fields_.erase( step );
+                }
+            }
+            else
+            {
+                num_done++;
+            }
+        }
+
+        writeSolidificationData();
+    }
+
+    // Write one snapshot (collectively over all servers) in the BOV format.
+    void writeField( const field_blocks& blocks )
+    {
+        const auto& header = blocks[0];
+        int step = header[IOFieldHeader::step];
+        int nc = header[IOFieldHeader::members];
+        int global_size[3] = {
+            static_cast<int>( header[IOFieldHeader::global_extent + 2] ),
+            static_cast<int>( header[IOFieldHeader::global_extent + 1] ),
+            static_cast<int>( header[IOFieldHeader::global_extent] ) * nc };
+
+        std::ostringstream name;
+        name << "grid_temperature_" << std::setfill( '0' ) << std::setw( 6 )
+             << step;
+        std::string data_file = name.str() + ".dat";
+
+        MPI_File fh;
+        MPI_File_open( server_comm_, data_file.c_str(),
+                       MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh );
+
+        // One collective write per block (servers may have different numbers
+        // of blocks)
+        int num_blocks = blocks.size();
+        int max_blocks;
+        MPI_Allreduce( &num_blocks, &max_blocks, 1, MPI_INT, MPI_MAX,
+                       server_comm_ );
+        for ( int b = 0; b < max_blocks; ++b )
+        {
+            if ( b < num_blocks )
+            {
+                const auto& block = blocks[b];
+                int sub_size[3] = {
+                    static_cast<int>( block[IOFieldHeader::extent + 2] ),
+                    static_cast<int>( block[IOFieldHeader::extent + 1] ),
+                    static_cast<int>( block[IOFieldHeader::extent] ) * nc };
+                int start[3] = {
+                    static_cast<int>( block[IOFieldHeader::offset + 2] ),
+                    static_cast<int>( block[IOFieldHeader::offset + 1] ),
+                    static_cast<int>( block[IOFieldHeader::offset] ) * nc };
+                MPI_Datatype file_type;
+                MPI_Type_create_subarray( 3, global_size, sub_size, start,
+                                          MPI_ORDER_C, MPI_DOUBLE,
+                                          &file_type );
+                MPI_Type_commit( &file_type );
+                MPI_File_set_view( fh, 0, MPI_DOUBLE, file_type, "native",
+                                   MPI_INFO_NULL );
+                MPI_File_write_all( fh, block.data() + IOFieldHeader::size,
+                                    block.size() - IOFieldHeader::size,
+                                    MPI_DOUBLE, MPI_STATUS_IGNORE );
+                MPI_Type_free( &file_type );
+            }
+            else
+            {
+                MPI_File_set_view( fh, 0, MPI_DOUBLE, MPI_DOUBLE, "native",
+                                   MPI_INFO_NULL );
+                MPI_File_write_all( fh, nullptr, 0, MPI_DOUBLE,
+                                    MPI_STATUS_IGNORE );
+            }
+        }
+        MPI_File_close( &fh );
+
+        if ( server_index_ == 0 )
+        {
+            std::ofstream bov( name.str() + ".bovh" );
+            bov << "TIME: " << header[IOFieldHeader::time] << std::endl;
+            bov << "DATA_FILE: " << data_file << std::endl;
+            bov << "DATA_SIZE: " << global_size[2] / nc << " "
+                << global_size[1] << " " << global_size[0] << std::endl;
+            bov << "DATA_FORMAT: DOUBLE" << std::endl;
+            bov << "DATA_COMPONENTS: " << nc << std::endl;
+            bov << "VARIABLE: temperature" << std::endl;
+            bov << "DATA_ENDIAN: LITTLE" << std::endl;
+            bov << "CENTERING: nodal" << std::endl;
+            bov << "BRICK_ORIGIN: " << header[IOFieldHeader::low_corner] << " "
+                << header[IOFieldHeader::low_corner + 1] << " "
+                << header[IOFieldHeader::low_corner + 2] << std::endl;
+            bov << "BRICK_SIZE:";
+            for ( int d = 0; d < 3; ++d )
+                bov << " "
+                    << ( header[IOFieldHeader::global_extent + d] - 1 ) *
+                           header[IOFieldHeader::cell_size];
+            bov << std::endl;
+        }
+    }
+
+    // Write the events from all compute ranks of this server to one file
+    // (optionally sorted by solidification time, and gzip compressed).
+    void writeSolidificationData()
+    {
+        if ( !sampling_enabled_ )
+            return;
+
+        std::chrono::high_resolution_clock::time_point start_time =
+            std::chrono::high_resolution_clock::now();
+
+        int num_events = events_.size() / num_cmpts_;
+        if ( sort_ )
+        {
+            std::vector<int> order( num_events );
+            std::iota( order.begin(), order.end(), 0 );
+            std::stable_sort( order.begin(), order.end(),
+                              [&]( const int a, const int b ) {
+                                  return events_[a * num_cmpts_ + 4] <
+                                         events_[b * num_cmpts_ + 4];
+                              } );
+            std::vector<double> sorted( events_.size() );
+            for ( int n = 0; n < num_events; ++n )
+                std::copy( events_.begin() + order[n] * num_cmpts_,
+                           events_.begin() + ( order[n] + 1 ) * num_cmpts_,
+                           sorted.begin() + n * num_cmpts_ );
+            events_.swap( sorted );
+        }
+
+        // create directory is not present, otherwise overwrite existing files
+        if ( mkdir( folder_name_.c_str(), 0777 ) != -1 )
+        {
+            std::cout << "Creating directory: " << folder_name_ << std::endl;
+        }
+
+        std::string filename( folder_name_ + "/data_" +
+                              std::to_string( server_index_ ) + ".csv" );
+        Kokkos::View<double**, Kokkos::LayoutRight, Kokkos::HostSpace,
+                     Kokkos::MemoryUnmanaged>
+            events_host( events_.data(), num_events, num_cmpts_ );
+        if ( compress_ )
+        {
+            std::ostringstream csv;
+            csv << std::fixed << std::setprecision( 10 );
+            writeEvents( csv, events_host, num_events, format_, num_members_ );
+            writeCompressed( filename + ".gz", csv.str() );
+        }
+        else
+        {
+            std::ofstream fout( filename );
+            fout << std::fixed << std::setprecision( 10 );
+            writeEvents( fout, events_host, num_events, format_,
+                         num_members_ );
+            fout.close();
+        }
+
+        MPI_Barrier( server_comm_ );
+        std::chrono::duration<double> elapsed_seconds =
+            std::chrono::high_resolution_clock::now() - start_time;
+        if ( server_index_ == 0 )
+            std::cout << "Solidification data written by I/O servers in "
+                      << std::fixed << std::setprecision( 6 )
+                      << elapsed_seconds.count() << " seconds" << std::endl;
+    }
+
+    // Write the text to a gzip file.
+    void writeCompressed( const std::string& filename,
+                          const std::string& text )
+    {
+#ifdef Finch_ENABLE_ZLIB
+        gzFile file = gzopen( filename.c_str(), "wb" );
+        if ( file == nullptr )
+            throw std::runtime_error( "Error: could not open " + filename );
+        // gzwrite takes at most UINT_MAX bytes at once
+        const std::size_t chunk = std::size_t( 1 ) << 30;
+        for ( std::size_t n = 0; n < text.size(); n += chunk )
+        {
+            unsigned len = std::min( chunk, text.size() - n );
+            if ( gzwrite( file, text.data() + n, len ) != int( len ) )
+            {
+                gzclose( file );
+                throw std::runtime_error( "Error: could not write " +
+                                          filename );
+            }
+        }
+        gzclose( file );
+#else
+        (void)text;
+        throw std::runtime_error( "Error: writing " + filename +
+                                  " requires Finch built with zlib" );
+#endif
+    }
+};
+
+} // namespace Finch
+
+#endif
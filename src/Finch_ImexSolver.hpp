@@ -0,0 +1,245 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file ImexSolver.hpp
+  \brief Heat transport solve, implicit in z and explicit in x and y
+*/
+
+#ifndef ImexSolver_H
+#define ImexSolver_H
+
+#include <array>
+#include <stdexcept>
+#include <type_traits>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+#include "Finch_Solver.hpp"
+
+namespace Finch
+{
+
+template <class SourceTag>
+struct ColumnTag
+{
+};
+
+/*
+  Implicit-explicit (IMEX) variant of the FTCS solver: conduction along z is
+  backward Euler, solved as one tridiagonal system per (i, j) column with the
+  Thomas algorithm, while x and y conduction, the source, and the latent heat
+  (effective heat capacity) are evaluated from the previous temperature as
+  before. The step is then limited only by the lateral stencil (Co <= 1/4
+  rather than 1/6). Each rank must own whole z columns.
+*/
+template <typename ViewType, typename EntityType, typename LocalMeshType>
+class ImexSolver : public Solver<ViewType, EntityType, LocalMeshType>
+{
+    using base_type = Solver<ViewType, EntityType, LocalMeshType>;
+    using memory_space = typename ViewType::memory_space;
+    using view_column = Kokkos::View<double***, memory_space>;
+
+  protected:
+    // Thomas algorithm upper diagonal after elimination
+    view_column c_prime_;
+
+    // owned z range and whether each end is adiabatic (mirrored ghost) or
+    // has a known ghost value
+    int k_min_;
+    int k_max_;
+    bool adiabatic_low_;
+    bool adiabatic_high_;
+
+  public:
+    ImexSolver( Inputs db, LocalMeshType local_mesh,
+                const std::array<std::size_t, 3> extents,
+                const bool adiabatic_low, const bool adiabatic_high )
+        : base_type( db, local_mesh )
+        , c_prime_( Kokkos::ViewAllocateWithoutInitializing( "imex_c_prime" ),
+                    extents[0], extents[1], extents[2] )
+        , k_min_( 0 )
+        , k_max_( 0 )
+        , adiabatic_low_( adiabatic_low )
+        , adiabatic_high_( adiabatic_high )
+    {
+    }
+
+    template <class ExecSpace, class IndexSpaceType>
+    void solve( ExecSpace exec_space, IndexSpaceType owned_space, ViewType& T,
+                ViewType& T0, const double beam_power,
+                const double beam_pos[3] )
+    {
+        // Update temperature views and beam parameters for current time step
+        this->T_ = T;
+
+        this->T0_ = T0;
+
+        this->power_ = beam_power;
+
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            this->position_[d] = beam_pos[d];
+        }
+
+        // One thread per column
+        k_min_ = owned_space.min( 2 );
+        k_max_ = owned_space.max( 2 );
+        Cabana::Grid::IndexSpace<3> column_space(
+            { owned_space.min( 0 ), owned_space.min( 1 ), k_min_ },
+            { owned_space.max( 0 ), owned_space.max( 1 ), k_min_ + 1 } );
+
+        if constexpr ( std::is_same<memory_space, Kokkos::HostSpace>::value )
+        {
+            this->launch( "solve_imex", exec_space, column_space,
+                          ColumnTag<HostTag>{}, *this );
+        }
+        else
+        {
+            this->launch( "solve_imex", exec_space, column_space,
+                          ColumnTag<DeviceTag>{}, *this );
+        }
+    }
+
+    // Tridiagonal solve for the column at (i, j)
+    template <class SourceTag>
+    KOKKOS_INLINE_FUNCTION void operator()( ColumnTag<SourceTag> tag,
+                                            const int i, const int j,
+                                            const int k ) const
+    {
+        EnergyRates rates = { 0.0, 0.0 };
+        ( *this )( tag, i, j, k, rates );
+    }
+
+    // Tridiagonal solve for the column at (i, j), summing the source and
+    // conduction terms (lateral from the previous temperature, and through the
+    // column ends from the new one)
+    template <class SourceTag>
+    KOKKOS_INLINE_FUNCTION void operator()( ColumnTag<SourceTag>, const int i,
+                                            const int j, const int,
+                                            EnergyRates& rates ) const
+    {
+        const auto& T = this->T_;
+        const auto& T0 = this->T0_;
+
+        // Forward elimination, storing the eliminated right hand side in T
+        double c_prev = 0.0;
+        double d_prev = 0.0;
+        for ( int k = k_min_; k < k_max_; ++k )
+        {
+            double x = T0( i, j, k, 0 );
+
+            double dt_by_rho_cp =
+                ( x >= this->solidus_ && x <= this->liquidus_ )
+                    ? this->dt_ / ( this->rho_cp_ + this->rho_Lf_by_dT_ )
+                    : this->dt_ / ( this->rho_cp_ );
+
+            double r = dt_by_rho_cp * this->k_by_dx2_;
+            double q = this->source( SourceTag{}, i, j, k );
+            double lateral = lateralLaplacian( i, j, k );
+            rates.deposited += q;
+            rates.conducted += lateral;
+            double rhs = x + dt_by_rho_cp * ( lateral + q );
+            double lower = -r;
+            double upper = -r;
+            double diag = 1.0 + 2.0 * r;
+
+            if ( k == k_min_ )
+            {
+                lower = 0.0;
+                if ( adiabatic_low_ )
+                    diag -= r;
+                else
+                    rhs += r * T0( i, j, k - 1, 0 );
+            }
+            if ( k == k_max_ - 1 )
+            {
+                upper = 0.0;
+                if ( adiabatic_high_ )
+                    diag -= r;
+                else
+                    rhs += r * T0( i, j, k + 1, 0 );
+            }
+
+            double denom = diag - lower * c_prev;
+            c_prev = upper / denom;
+            d_prev = ( rhs - lower * d_prev ) / denom;
+            c_prime_( i, j, k ) = c_prev;
+            T( i, j, k, 0 ) = d_prev;
+        }
+
+        // Back substitution
+        for ( int k = k_max_ - 2; k >= k_min_; --k )
+            T( i, j, k, 0 ) -= c_prime_( i, j, k ) * T( i, j, k + 1, 0 );
+
+        // Conduction along z cancels within the column except at its ends
+        if ( !adiabatic_low_ )
+            rates.conducted +=
+                ( T0( i, j, k_min_ - 1, 0 ) - T( i, j, k_min_, 0 ) ) *
+                this->k_by_dx2_;
+        if ( !adiabatic_high_ )
+            rates.conducted +=
+                ( T0( i, j, k_max_, 0 ) - T( i, j, k_max_ - 1, 0 ) ) *
+                this->k_by_dx2_;
+    }
+
+    // Centered space laplacian stencil in x and y only
+    KOKKOS_INLINE_FUNCTION
+    auto lateralLaplacian( const int i, const int j, const int k ) const
+    {
+        const auto& T0 = this->T0_;
+        return ( T0( i - 1, j, k, 0 ) + T0( i + 1, j, k, 0 ) +
+                 T0( i, j - 1, k, 0 ) + T0( i, j + 1, k, 0 ) -
+                 4.0 * T0( i, j, k, 0 ) ) *
+               this->k_by_dx2_;
+    }
+};
+
+template <class SolverType>
+struct isImexSolver : std::false_type
+{
+};
+
+template <typename ViewType, typename EntityType, typename LocalMeshType>
+struct isImexSolver<ImexSolver<ViewType, EntityType, LocalMeshType>>
+    : std::true_type
+{
+};
+
+// Create an IMEX solver based on the grid details and simulation inputs.
+template <typename MemorySpace>
+auto createImexSolver( Inputs db, Grid<MemorySpace> grid )
+{
+    using entity_type = typename Grid<MemorySpace>::entity_type;
+    using view_type = typename Grid<MemorySpace>::view_type;
+    using mesh_type = typename Grid<MemorySpace>::local_mesh_type;
+
+    auto& global_grid = grid.getLocalGrid()->globalGrid();
+    if ( global_grid.dimNumBlock( 2 ) != 1 )
+        throw std::runtime_error(
+            "Error: the imex solver requires one rank along z" );
+
+    auto types = grid.getBoundaryTypes();
+    auto T = grid.getTemperature();
+    std::array<std::size_t, 3> extents = { T.extent( 0 ), T.extent( 1 ),
+                                           T.extent( 2 ) };
+
+    return ImexSolver<view_type, entity_type, mesh_type>(
+        db, grid.getLocalMesh(), extents, types[4] == "adiabatic",
+        types[5] == "adiabatic" );
+}
+
+} // namespace Finch
+
+#endif
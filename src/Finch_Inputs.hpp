@@ -19,14 +19,17 @@
 
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include <Finch_Core_Config.hpp>
 #include <Finch_Version.hpp>
 
 namespace Finch
@@ -37,6 +40,16 @@ namespace Finch
     if ( comm_rank == 0 )                                                      \
     std::cout
 
+// Parse a JSON input file
+inline nlohmann::json readInputFile( const std::string filename )
+{
+    std::ifstream db_stream( filename );
+    if ( !db_stream.good() )
+        throw std::runtime_error( "Cannot find input file " + filename );
+
+    return nlohmann::json::parse( db_stream );
+}
+
 struct Output
 {
     int total_steps;
@@ -87,6 +100,16 @@ struct Source
     std::string scan_path_file;
 };
 
+struct Members
+{
+    // Ensemble members share the grid and are stored as separate components
+    // of the temperature field; each may vary the heat source.
+    int size;
+    std::vector<double> absorption;
+    std::vector<double> power_scale;
+    std::vector<std::string> scan_path_file;
+};
+
 struct Properties
 {
     double density;
@@ -98,12 +121,97 @@ struct Properties
     double liquidus;
 };
 
+struct Numerics
+{
+    // Temperature solver: "ftcs" (default), "imex" (implicit in z, explicit
+    // in x and y), "spectral" (linear conduction only, advanced exactly in
+    // cosine space), "greens_function" (linear conduction only, evaluated
+    // at requested points), or "steady" (melt pool of the last track in the
+    // beam frame)
+    std::string solver = "ftcs";
+
+    // Steady solver convergence (maximum rate of change, K/s) and iteration
+    // limit
+    double steady_tolerance = 100.0;
+    int steady_max_iterations = 1000000;
+
+    // Green's function history aggregation (relative to the kernel width)
+    // and truncation (peak temperature contribution) tolerances
+    double aggregation_tolerance = 0.1;
+    double truncation_tolerance = 1e-3;
+
+    // Check the global energy balance (FTCS and IMEX solvers), warning above
+    // the relative imbalance (of the energy deposited and conducted through
+    // the boundaries)
+    bool energy_monitor = false;
+    double energy_tolerance = 0.01;
+};
+
+struct Probes
+{
+    // Individual points and (optionally) a plane of grid points normal to
+    // slice_axis, for temperature output without a full grid solve
+    std::vector<std::array<double, 3>> points;
+    bool slice = false;
+    int slice_axis;
+    double slice_position;
+    // Region of grid points used for solidification sampling (required to
+    // sample: every point is evaluated against every source each step)
+    bool region = false;
+    std::array<double, 3> region_low_corner;
+    std::array<double, 3> region_high_corner;
+};
+
+struct Deposition
+{
+    // Material only exists once deposited (directed energy deposition): a
+    // cell becomes active when the powered beam passes within the bead, i.e.
+    // within half the bead width horizontally and the bead height below the
+    // beam. Cells at or below the substrate height are active from the start.
+    bool enabled = false;
+    double bead_width;
+    double bead_height;
+    double substrate_height = 0.0;
+};
+
+struct Parareal
+{
+    // Parallel-in-time integration: the simulation is split into time slices,
+    // each run by its own group of ranks
+    int ranks_per_slice = 1;
+    int max_iterations = 0;
+    // spectral (linear, no latent heat) coarse steps per slice
+    int coarse_steps = 10;
+    // convergence of the slice start temperatures (max difference)
+    double tolerance = 1.0;
+    // convergence of the solidification statistics (relative change)
+    double statistics_tolerance = 0.01;
+};
+
+struct IO
+{
+    // Ranks reserved to aggregate and write the output (for the whole job, or
+    // for each node if servers_per_node is set); none writes from every rank
+    int server_ranks = 0;
+    int servers_per_node = 0;
+    // Steps between shipping new solidification events to the servers
+    int interval = 100;
+    // Sort the aggregated events by solidification time
+    bool sort = false;
+    // Write the aggregated events gzip compressed
+    bool compress = false;
+
+    bool enabled() const { return server_ranks > 0 || servers_per_node > 0; }
+};
+
 struct Sampling
 {
     std::string type;
     std::string format;
     std::string directory_name = "solidification";
     bool enabled;
+    // Steps between checks for liquidus crossings
+    int interval = 1;
 };
 
 struct TimeMonitor
@@ -155,7 +263,13 @@ class Inputs
     Time time;
     Space space;
     Source source;
+    Members members;
     Properties properties;
+    Numerics numerics;
+    Deposition deposition;
+    Probes probes;
+    Parareal parareal;
+    IO io;
     Sampling sampling;
     TimeMonitor time_monitor;
 
@@ -177,6 +291,28 @@ class Inputs
         MPI_Comm_size( comm, &comm_size );
         parseInputFile( comm, filename );
     }
+    // constructor from already parsed inputs (e.g. one case of an ensemble)
+    Inputs( MPI_Comm comm, const nlohmann::json& db )
+    {
+        MPI_Comm_rank( comm, &comm_rank );
+        MPI_Comm_size( comm, &comm_size );
+        parseInput( comm, db );
+    }
+
+    // Restrict the simulation to a sub-interval with the same time step
+    // (e.g. a single time slice), disabling field output.
+    void setTimeRange( const double start, const double end )
+    {
+        time.start_time = start;
+        time.end_time = end;
+        time.time = start;
+        time.num_steps =
+            static_cast<int>( std::round( ( end - start ) / time.time_step ) );
+
+        time.output.interval = time.num_steps + 1;
+        time.monitor.setInterval( time.num_steps );
+        time_monitor.num_steps = time.num_steps;
+    }
 
     void write()
     {
@@ -226,6 +362,61 @@ class Inputs
         Info << "    Z: " << source.two_sigma[2] << std::endl;
         Info << "  scan path file: " << source.scan_path_file << std::endl;
 
+        // Print ensemble members
+        if ( members.size > 1 )
+        {
+            Info << "Members:" << std::endl;
+            for ( int e = 0; e < members.size; ++e )
+            {
+                Info << "  " << e << ": absorption "
+                     << members.absorption[e] << ", power scale "
+                     << members.power_scale[e] << ", scan path file "
+                     << members.scan_path_file[e] << std::endl;
+            }
+        }
+
+        // Print solver options
+        Info << "Numerics:" << std::endl;
+        Info << "  solver: " << numerics.solver << std::endl;
+        if ( numerics.solver == "greens_function" )
+        {
+            Info << "  aggregation tolerance: "
+                 << numerics.aggregation_tolerance << std::endl;
+            Info << "  truncation tolerance: " << numerics.truncation_tolerance
+                 << std::endl;
+            Info << "  probe points: " << probes.points.size() << std::endl;
+            if ( probes.slice )
+                Info << "  slice: axis " << probes.slice_axis << " at "
+                     << probes.slice_position << std::endl;
+            if ( probes.region )
+                Info << "  region: (" << probes.region_low_corner[0] << ", "
+                     << probes.region_low_corner[1] << ", "
+                     << probes.region_low_corner[2] << ") to ("
+                     << probes.region_high_corner[0] << ", "
+                     << probes.region_high_corner[1] << ", "
+                     << probes.region_high_corner[2] << ")" << std::endl;
+        }
+        if ( numerics.energy_monitor )
+            Info << "  energy tolerance: " << numerics.energy_tolerance
+                 << std::endl;
+        if ( numerics.solver == "steady" )
+        {
+            Info << "  steady tolerance: " << numerics.steady_tolerance
+                 << std::endl;
+            Info << "  steady max iterations: "
+                 << numerics.steady_max_iterations << std::endl;
+        }
+
+        // Print deposition options
+        if ( deposition.enabled )
+        {
+            Info << "Deposition:" << std::endl;
+            Info << "  bead width: " << deposition.bead_width << std::endl;
+            Info << "  bead height: " << deposition.bead_height << std::endl;
+            Info << "  substrate height: " << deposition.substrate_height
+                 << std::endl;
+        }
+
         // Print solidification output options
         Info << "Sampling:" << std::endl;
         if ( sampling.enabled )
@@ -266,7 +457,12 @@ class Inputs
 
     void parseInputFile( MPI_Comm comm, const std::string filename )
     {
-        readInput( filename );
+        parseInput( comm, readInputFile( filename ) );
+    }
+
+    void parseInput( MPI_Comm comm, const nlohmann::json& db )
+    {
+        readInput( db );
 
         write();
 
@@ -292,12 +488,8 @@ class Inputs
         time_monitor = TimeMonitor( comm, time );
     }
 
-    void readInput( const std::string filename )
+    void readInput( nlohmann::json db )
     {
-        // parse input file
-        std::ifstream db_stream( filename );
-        nlohmann::json db = nlohmann::json::parse( db_stream );
-
         // Read time components
         time.Co = db["time"]["Co"];
         time.start_time = db["time"]["start_time"];
@@ -351,6 +543,160 @@ class Inputs
 
         source.scan_path_file = db["source"]["scan_path_file"];
 
+        // Read ensemble members (optional), defaulting to the single source
+        members.size = 1;
+        members.absorption = { source.absorption };
+        members.power_scale = { 1.0 };
+        members.scan_path_file = { source.scan_path_file };
+        if ( db.contains( "members" ) )
+        {
+            members.size = db["members"].size();
+            if ( members.size < 1 )
+                throw std::runtime_error(
+                    "Error: at least one ensemble member is required" );
+
+            members.absorption.clear();
+            members.power_scale.clear();
+            members.scan_path_file.clear();
+            for ( auto& member : db["members"] )
+            {
+                members.absorption.push_back(
+                    member.value( "absorption", source.absorption ) );
+                members.power_scale.push_back(
+                    member.value( "power_scale", 1.0 ) );
+                members.scan_path_file.push_back( member.value(
+                    "scan_path_file", source.scan_path_file ) );
+            }
+        }
+
+        // Read numerics components (optional)
+        if ( db.contains( "numerics" ) )
+        {
+            numerics.solver = db["numerics"].value( "solver", "ftcs" );
+            if ( numerics.solver != "ftcs" && numerics.solver != "imex" &&
+                 numerics.solver != "spectral" &&
+                 numerics.solver != "greens_function" &&
+                 numerics.solver != "steady" )
+                throw std::runtime_error( "Error: invalid solver type " +
+                                          numerics.solver );
+            bool linear = numerics.solver == "spectral" ||
+                          numerics.solver == "greens_function";
+            if ( linear && properties.latent_heat > 0 )
+                throw std::runtime_error( "Error: the " + numerics.solver +
+                                          " solver requires linear "
+                                          "conduction (latent_heat = 0)" );
+            if ( numerics.solver != "ftcs" && members.size > 1 )
+                throw std::runtime_error( "Error: the " + numerics.solver +
+                                          " solver does not support "
+                                          "ensemble members" );
+
+            // The imex solver keeps whole z columns on each rank: only the
+            // default decomposition (all zero) is adjusted
+            if ( numerics.solver == "imex" && space.ranks_per_dim[2] != 1 )
+            {
+                if ( space.ranks_per_dim[2] != 0 )
+                    throw std::runtime_error(
+                        "Error: the imex solver requires one rank along z "
+                        "(ranks_per_dim[2] = 1)" );
+                space.ranks_per_dim[2] = 1;
+                Info << "Ranks per dimension: z set to 1 for the imex solver"
+                     << std::endl;
+            }
+
+            numerics.aggregation_tolerance =
+                db["numerics"].value( "aggregation_tolerance", 0.1 );
+            numerics.truncation_tolerance =
+                db["numerics"].value( "truncation_tolerance", 1e-3 );
+            numerics.steady_tolerance =
+                db["numerics"].value( "steady_tolerance", 100.0 );
+            numerics.steady_max_iterations =
+                db["numerics"].value( "steady_max_iterations", 1000000 );
+            numerics.energy_monitor =
+                db["numerics"].value( "energy_monitor", false );
+            if ( numerics.energy_monitor &&
+                 ( ( numerics.solver != "ftcs" &&
+                     numerics.solver != "imex" ) ||
+                   members.size > 1 ) )
+                throw std::runtime_error( "Error: the energy monitor requires "
+                                          "the ftcs or imex solver and a "
+                                          "single member" );
+            numerics.energy_tolerance =
+                db["numerics"].value( "energy_tolerance", 0.01 );
+        }
+
+        // Read deposition components (optional)
+        if ( db.contains( "deposition" ) )
+        {
+            deposition.enabled = true;
+            deposition.bead_width = db["deposition"]["bead_width"];
+            deposition.bead_height = db["deposition"]["bead_height"];
+            deposition.substrate_height =
+                db["deposition"].value( "substrate_height", 0.0 );
+            if ( deposition.bead_width <= 0.0 ||
+                 deposition.bead_height <= 0.0 )
+                throw std::runtime_error(
+                    "Error: the deposition bead size must be positive" );
+            if ( numerics.solver != "ftcs" || members.size > 1 )
+                throw std::runtime_error( "Error: deposition requires the "
+                                          "ftcs solver and a single member" );
+        }
+
+        // Read probe components (optional)
+        if ( db.contains( "probes" ) )
+        {
+            if ( db["probes"].contains( "points" ) )
+                probes.points = db["probes"]["points"]
+                                    .get<std::vector<std::array<double, 3>>>();
+            if ( db["probes"].contains( "slice" ) )
+            {
+                probes.slice = true;
+                probes.slice_axis = db["probes"]["slice"]["axis"];
+                probes.slice_position = db["probes"]["slice"]["position"];
+            }
+            if ( db["probes"].contains( "region" ) )
+            {
+                probes.region = true;
+                probes.region_low_corner =
+                    db["probes"]["region"]["low_corner"];
+                probes.region_high_corner =
+                    db["probes"]["region"]["high_corner"];
+            }
+        }
+
+        // Read parareal components (optional)
+        if ( db.contains( "parareal" ) )
+        {
+            parareal.ranks_per_slice =
+                db["parareal"].value( "ranks_per_slice", 1 );
+            parareal.max_iterations =
+                db["parareal"].value( "max_iterations", 0 );
+            parareal.coarse_steps = db["parareal"].value( "coarse_steps", 10 );
+            parareal.tolerance = db["parareal"].value( "tolerance", 1.0 );
+            parareal.statistics_tolerance =
+                db["parareal"].value( "statistics_tolerance", 0.01 );
+        }
+
+        // Read I/O server components (optional)
+        if ( db.contains( "io" ) )
+        {
+            io.server_ranks = db["io"].value( "server_ranks", 0 );
+            io.servers_per_node = db["io"].value( "servers_per_node", 0 );
+            io.interval = db["io"].value( "interval", 100 );
+            io.sort = db["io"].value( "sort", false );
+            io.compress = db["io"].value( "compress", false );
+            if ( io.interval < 1 )
+                throw std::runtime_error( "I/O interval must be positive" );
+            if ( io.enabled() && numerics.solver == "steady" )
+                throw std::runtime_error(
+                    "Error: the steady solver does not use I/O servers" );
+#ifndef Finch_ENABLE_ZLIB
+            if ( io.compress )
+                throw std::runtime_error(
+                    "Error: compressed I/O output requires Finch built with "
+                    "zlib" );
+#endif
+        }
+
         // Read sampling components
         sampling.enabled = false;
         if ( db.contains( "sampling" ) )
@@ -378,6 +724,16 @@ class Inputs
             {
                 sampling.directory_name = db["sampling"]["directory_name"];
             }
+
+            sampling.interval = db["sampling"].value( "interval", 1 );
+            if ( sampling.interval < 1 )
+                throw std::runtime_error(
+                    "Sampling interval must be positive" );
+            if ( sampling.enabled && numerics.solver == "greens_function" &&
+                 !probes.region )
+                throw std::runtime_error(
+                    "Error: the greens_function solver requires a "
+                    "probes region for solidification sampling" );
         }
     }
 };
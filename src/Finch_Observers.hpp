@@ -0,0 +1,161 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file Observers.hpp
+  \brief Compile-time list of observers called from the time loop
+*/
+
+#ifndef Observers_H
+#define Observers_H
+
+#include <type_traits>
+#include <utility>
+
+#include "Finch_Inputs.hpp"
+
+namespace Finch
+{
+
+/*
+  An observer is any class with (all optional):
+
+    static constexpr bool enabled;      // false removes it at compile time
+    int interval() const;               // cadence in steps, default 1
+    void observe( const Context& );     // host callback when due
+
+  The callbacks of the due observers are called in the order given.
+*/
+
+// State of the completed step passed to each observer.
+template <class GridType, class BeamType, class SolverType>
+struct StepContext
+{
+    // Last completed step (several may be combined into one update)
+    int step;
+    double time;
+    double dt;
+    Inputs& inputs;
+    GridType& grid;
+    BeamType& beam;
+    SolverType& solver;
+};
+
+namespace Impl
+{
+template <class, class = void>
+struct ObserverEnabled : std::true_type
+{
+};
+template <class O>
+struct ObserverEnabled<O, std::void_t<decltype( O::enabled )>>
+    : std::integral_constant<bool, O::enabled>
+{
+};
+
+template <class, class = void>
+struct ObserverHasInterval : std::false_type
+{
+};
+template <class O>
+struct ObserverHasInterval<
+    O, std::void_t<decltype( std::declval<const O&>().interval() )>>
+    : std::true_type
+{
+};
+
+template <class, class, class = void>
+struct ObserverHasObserve : std::false_type
+{
+};
+template <class O, class Context>
+struct ObserverHasObserve<O, Context,
+                          std::void_t<decltype( std::declval<O&>().observe(
+                              std::declval<const Context&>() ) )>>
+    : std::true_type
+{
+};
+
+template <class O>
+constexpr bool isEnabled()
+{
+    return ObserverEnabled<std::decay_t<O>>::value;
+}
+
+// Whether any of the steps in [first, last] is a multiple of the cadence.
+template <class O>
+bool isDue( const O& observer, const int first, const int last )
+{
+    int interval = 1;
+    if constexpr ( ObserverHasInterval<O>::value )
+        interval = observer.interval();
+    return interval > 0 && ( last + 1 ) / interval > first / interval;
+}
+
+template <class Context, class O>
+void notify( const Context& ctx, const int first, O& observer )
+{
+    if constexpr ( isEnabled<O>() && ObserverHasObserve<O, Context>::value )
+    {
+        if ( isDue( observer, first, ctx.step ) )
+            observer.observe( ctx );
+    }
+}
+} // namespace Impl
+
+// Call all observers due for the completed steps [first, ctx.step].
+template <class Context, class... Observers>
+void observe( const Context& ctx, const int first, Observers&... observers )
+{
+    ( Impl::notify( ctx, first, observers ), ... );
+}
+
+// Write the timing information.
+struct TimeMonitorObserver
+{
+    int interval_;
+
+    TimeMonitorObserver( const Inputs& inputs )
+        : interval_( inputs.time.monitor.interval )
+    {
+    }
+
+    int interval() const { return interval_; }
+
+    template <class Context>
+    void observe( const Context& ctx )
+    {
+        ctx.inputs.time_monitor.write( ctx.step );
+    }
+};
+
+// Write the temperature field (unless sent to I/O servers instead).
+struct FieldOutputObserver
+{
+    int interval_;
+
+    FieldOutputObserver( const Inputs& inputs )
+        : interval_( inputs.io.enabled() ? 0 : inputs.time.output.interval )
+    {
+    }
+
+    int interval() const { return interval_; }
+
+    template <class Context>
+    void observe( const Context& ctx )
+    {
+        ctx.grid.output( ctx.step, ctx.step * ctx.inputs.time.time_step );
+    }
+};
+
+} // namespace Finch
+
+#endif
@@ -0,0 +1,304 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file Parareal.hpp
+  \brief Parallel-in-time integration of a single layer over time slices
+*/
+
+#ifndef Parareal_H
+#define Parareal_H
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mpi.h>
+#include <string>
+
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+#include "Finch_Run.hpp"
+#include "Finch_Solver.hpp"
+#include "Finch_SpectralSolver.hpp"
+#include "MovingBeam/Finch_MovingBeam.hpp"
+
+namespace Finch
+{
+
+/*
+  Parareal: the simulation is split into time slices, each owned by a group
+  of ranks with its own (identically decomposed) grid. Every iteration runs
+  the fine propagator (Layer::run with the FTCS solver) for all slices
+  concurrently, followed by a sequential sweep of the coarse propagator (a few
+  large spectral steps, neglecting latent heat) which corrects the slice
+  start states:
+
+    U_{s+1} <- G( U_s ) + F( U_s^old ) - G( U_s^old )
+
+  Rank r of slice s exchanges states only with rank r of slices s - 1 and
+  s + 1 (through the world communicator).
+*/
+template <class MemorySpace>
+class PararealLayer
+{
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using grid_type = Grid<memory_space>;
+    using view_type = typename grid_type::view_type;
+
+    MPI_Comm world_comm_;
+    int slice_;
+    int num_slices_;
+    int group_size_;
+    int group_rank_;
+
+    Inputs inputs_;
+    double slice_start_;
+    double slice_end_;
+
+    // slice start state, coarse and fine results from that state
+    view_type U_;
+    view_type G_;
+    view_type F_;
+
+    // solidification statistics from the latest fine run
+    double num_events_;
+    double mean_cooling_rate_;
+
+    int worldRank( const int slice ) const
+    {
+        return slice * group_size_ + group_rank_;
+    }
+
+    view_type createState( const std::string& name, grid_type& grid )
+    {
+        auto T = grid.getTemperature();
+        return view_type( name, T.extent( 0 ), T.extent( 1 ), T.extent( 2 ),
+                          T.extent( 3 ) );
+    }
+
+  public:
+    PararealLayer( MPI_Comm world_comm, MPI_Comm group_comm,
+                   const Inputs& inputs, grid_type& grid )
+        : world_comm_( world_comm )
+        , inputs_( inputs )
+        , num_events_( 0.0 )
+        , mean_cooling_rate_( 0.0 )
+    {
+        int world_size;
+        MPI_Comm_size( world_comm_, &world_size );
+        MPI_Comm_size( group_comm, &group_size_ );
+        MPI_Comm_rank( group_comm, &group_rank_ );
+        int world_rank;
+        MPI_Comm_rank( world_comm_, &world_rank );
+        num_slices_ = world_size / group_size_;
+        slice_ = world_rank / group_size_;
+
+        // Equal numbers of (fine) steps per slice
+        double dt = inputs.time.time_step;
+        int num_steps = inputs.time.num_steps;
+        int first = slice_ * num_steps / num_slices_;
+        int last = ( slice_ + 1 ) * num_steps / num_slices_;
+        slice_start_ = inputs.time.start_time + first * dt;
+        slice_end_ = inputs.time.start_time + last * dt;
+        inputs_.setTimeRange( slice_start_, slice_end_ );
+
+        // Separate output for each slice
+        inputs_.sampling.directory_name +=
+            "_slice_" + std::to_string( slice_ );
+
+        U_ = createState( "parareal_start", grid );
+        G_ = createState( "parareal_coarse", grid );
+        F_ = createState( "parareal_fine", grid );
+        Kokkos::deep_copy( U_, grid.getTemperature() );
+    }
+
+    // Coarse propagator over this slice from the given state.
+    template <class SpectralType>
+    void coarse( grid_type& grid, SpectralType& coarse_solver,
+                 const view_type& U, view_type& G )
+    {
+        MovingBeam beam( inputs_.source.scan_path_file );
+        grid.setTemperature( U );
+
+        int num_coarse = inputs_.parareal.coarse_steps;
+        double dt = ( slice_end_ - slice_start_ ) / num_coarse;
+        auto owned_space = grid.getIndexSpace();
+        for ( int n = 0; n < num_coarse; ++n )
+        {
+            // beam frozen at the middle of each coarse step
+            beam.move( slice_start_ + ( n + 0.5 ) * dt );
+            double beam_pos[3];
+            for ( std::size_t d = 0; d < 3; ++d )
+                beam_pos[d] = beam.position( d );
+
+            grid.swapTemperature();
+            auto T = grid.getTemperature();
+            auto T0 = grid.getPreviousTemperature();
+            coarse_solver.solve( exec_space(), owned_space, T, T0,
+                                 beam.power(), beam_pos, dt );
+            grid.updateBoundaries();
+            grid.gather();
+        }
+        Kokkos::deep_copy( G, grid.getTemperature() );
+    }
+
+    // Fine propagator over this slice from the start state, returning the
+    // layer (with solidification data for this slice).
+    template <class SolverType>
+    auto fine( grid_type& grid, SolverType& fd )
+    {
+        Inputs inputs = inputs_;
+        MovingBeam beam( inputs.source.scan_path_file );
+        grid.setTemperature( U_ );
+
+        Layer<memory_space> app( inputs, grid );
+        app.run( exec_space(), inputs, grid, beam, fd );
+        Kokkos::deep_copy( F_, grid.getTemperature() );
+
+        return app;
+    }
+
+    // Iterate until the slice start states and solidification statistics
+    // converge (or the maximum number of iterations is reached).
+    void run( grid_type& grid )
+    {
+        auto fd = createSolver( inputs_, grid );
+        auto coarse_solver = createSpectralSolver( inputs_, grid );
+
+        int comm_rank;
+        MPI_Comm_rank( world_comm_, &comm_rank );
+
+        // Initial coarse sweep
+        sweep( grid, coarse_solver, false );
+
+        int max_iterations = inputs_.parareal.max_iterations > 0
+                                 ? inputs_.parareal.max_iterations
+                                 : num_slices_;
+        for ( int k = 0; k < max_iterations; ++k )
+        {
+            auto app = fine( grid, fd );
+            bool statistics_converged = updateStatistics( app, k );
+
+            // Sequential correction of the start states
+            view_type U_old = createState( "parareal_previous", grid );
+            Kokkos::deep_copy( U_old, U_ );
+            sweep( grid, coarse_solver, true );
+
+            double local_change = maxDifference( U_, U_old );
+            double change;
+            MPI_Allreduce( &local_change, &change, 1, MPI_DOUBLE, MPI_MAX,
+                           world_comm_ );
+            if ( comm_rank == 0 )
+                std::cout << "Parareal iteration " << k
+                          << ": max start temperature change " << std::fixed
+                          << std::setprecision( 6 ) << change << std::endl;
+
+            // The fine results are consistent with the (converged) starts
+            if ( change < inputs_.parareal.tolerance && statistics_converged )
+            {
+                app.writeSolidificationData( grid.getComm() );
+                break;
+            }
+            if ( k == max_iterations - 1 )
+            {
+                if ( comm_rank == 0 )
+                    std::cout << "Warning: parareal did not converge"
+                              << std::endl;
+                app.writeSolidificationData( grid.getComm() );
+            }
+        }
+    }
+
+    // Sequential sweep over slices: receive the start state from the
+    // previous slice, propagate, and send the next start state on.
+    template <class SpectralType>
+    void sweep( grid_type& grid, SpectralType& coarse_solver,
+                const bool correct )
+    {
+        if ( slice_ > 0 )
+            MPI_Recv( U_.data(), U_.size(), MPI_DOUBLE, worldRank( slice_ - 1 ),
+                      0, world_comm_, MPI_STATUS_IGNORE );
+
+        view_type G_new = createState( "parareal_coarse_new", grid );
+        coarse( grid, coarse_solver, U_, G_new );
+
+        // Next start state: corrected coarse result
+        view_type next = createState( "parareal_next", grid );
+        auto G_old = G_;
+        auto F = F_;
+        Kokkos::parallel_for(
+            "parareal_correct",
+            Kokkos::RangePolicy<exec_space>( 0, next.size() ),
+            KOKKOS_LAMBDA( const int n ) {
+                next.data()[n] = correct ? G_new.data()[n] + F.data()[n] -
+                                               G_old.data()[n]
+                                         : G_new.data()[n];
+            } );
+        Kokkos::fence();
+        G_ = G_new;
+
+        if ( slice_ < num_slices_ - 1 )
+            MPI_Send( next.data(), next.size(), MPI_DOUBLE,
+                      worldRank( slice_ + 1 ), 0, world_comm_ );
+    }
+
+    double maxDifference( const view_type& a, const view_type& b )
+    {
+        double max = 0.0;
+        Kokkos::parallel_reduce(
+            "parareal_difference",
+            Kokkos::RangePolicy<exec_space>( 0, a.size() ),
+            KOKKOS_LAMBDA( const int n, double& m ) {
+                double diff = Kokkos::fabs( a.data()[n] - b.data()[n] );
+                if ( diff > m )
+                    m = diff;
+            },
+            Kokkos::Max<double>( max ) );
+        return max;
+    }
+
+    // Update the solidification statistics (number of events and mean
+    // cooling rate, over all slices), returning true if converged.
+    template <class LayerType>
+    bool updateStatistics( LayerType& app, const int iteration )
+    {
+        if ( !inputs_.sampling.enabled )
+            return true;
+
+        auto data = app.getSolidificationData();
+        double local[2] = { static_cast<double>( data.extent( 0 ) ), 0.0 };
+        for ( std::size_t n = 0; n < data.extent( 0 ); ++n )
+            local[1] += data( n, 5 );
+        double global[2];
+        MPI_Allreduce( local, global, 2, MPI_DOUBLE, MPI_SUM, world_comm_ );
+        double mean_cooling_rate =
+            ( global[0] > 0 ) ? global[1] / global[0] : 0.0;
+
+        double tol = inputs_.parareal.statistics_tolerance;
+        bool converged =
+            iteration > 0 &&
+            std::fabs( global[0] - num_events_ ) <=
+                tol * std::max( global[0], 1.0 ) &&
+            std::fabs( mean_cooling_rate - mean_cooling_rate_ ) <=
+                tol * std::max( std::fabs( mean_cooling_rate ), 1.0 );
+
+        num_events_ = global[0];
+        mean_cooling_rate_ = mean_cooling_rate;
+        return converged;
+    }
+};
+
+} // namespace Finch
+
+#endif
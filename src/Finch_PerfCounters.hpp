@@ -0,0 +1,301 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file PerfCounters.hpp
+  \brief Hardware counters and timing for individual kernels
+*/
+
+#ifndef PerfCounters_H
+#define PerfCounters_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <Kokkos_Core.hpp>
+
+namespace Finch
+{
+
+/*
+  Linux perf_event_open counters for the calling process, opened once for
+  every thread that exists at construction (i.e. after Kokkos is initialized,
+  so that the host thread pool is included) and summed over threads. Events
+  the kernel or hardware does not support (or perf_event_paranoid forbids) are
+  reported as unavailable, and on other systems nothing is counted. Floating
+  point operations have no generic event: a raw, processor specific event
+  code may be given instead (e.g. FP_ARITH_INST_RETIRED on x86).
+*/
+class PerfCounters
+{
+  public:
+    enum Event
+    {
+        cycles = 0,
+        instructions,
+        llc_misses,
+        fp_ops,
+        num_events
+    };
+
+    using counts_type = std::array<std::uint64_t, num_events>;
+
+    PerfCounters( const bool enabled = true, const std::uint64_t fp_event = 0 )
+    {
+#ifdef __linux__
+        if ( !enabled )
+            return;
+
+        std::vector<int> threads;
+        if ( DIR* dir = opendir( "/proc/self/task" ) )
+        {
+            while ( dirent* entry = readdir( dir ) )
+                if ( entry->d_name[0] != '.' )
+                    threads.push_back( std::atoi( entry->d_name ) );
+            closedir( dir );
+        }
+
+        for ( int tid : threads )
+        {
+            open( cycles, tid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES );
+            open( instructions, tid, PERF_TYPE_HARDWARE,
+                  PERF_COUNT_HW_INSTRUCTIONS );
+            open( llc_misses, tid, PERF_TYPE_HARDWARE,
+                  PERF_COUNT_HW_CACHE_MISSES );
+            if ( fp_event )
+                open( fp_ops, tid, PERF_TYPE_RAW, fp_event );
+        }
+#else
+        (void)enabled;
+        (void)fp_event;
+#endif
+    }
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for ( auto& event_fds : fds_ )
+            for ( int fd : event_fds )
+                close( fd );
+#endif
+    }
+
+    PerfCounters( const PerfCounters& ) = delete;
+    PerfCounters& operator=( const PerfCounters& ) = delete;
+
+    bool available( const Event e ) const { return !fds_[e].empty(); }
+
+    // Reset and start all counters
+    void start()
+    {
+#ifdef __linux__
+        for ( auto& event_fds : fds_ )
+            for ( int fd : event_fds )
+            {
+                ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+                ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+            }
+#endif
+    }
+
+    // Stop all counters and return the counts (summed over threads)
+    counts_type stop()
+    {
+        counts_type counts = {};
+#ifdef __linux__
+        for ( int e = 0; e < num_events; ++e )
+            for ( int fd : fds_[e] )
+            {
+                ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+                std::uint64_t value = 0;
+                if ( read( fd, &value, sizeof( value ) ) ==
+                     sizeof( value ) )
+                    counts[e] += value;
+            }
+#endif
+        return counts;
+    }
+
+  protected:
+#ifdef __linux__
+    void open( const Event e, const int tid, const std::uint32_t type,
+               const std::uint64_t config )
+    {
+        perf_event_attr attr = {};
+        attr.size = sizeof( attr );
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = static_cast<int>( syscall( SYS_perf_event_open, &attr, tid,
+                                            -1, -1, PERF_FLAG_FD_CLOEXEC ) );
+        if ( fd >= 0 )
+            fds_[e].push_back( fd );
+    }
+#endif
+
+    std::array<std::vector<int>, num_events> fds_;
+};
+
+// Accumulated counts and time for one kernel.
+struct KernelCounts
+{
+    int calls = 0;
+    double seconds = 0.0;
+    PerfCounters::counts_type counts = {};
+
+    // Cells updated per call and (if the FP event is not available) the
+    // nominal floating point operations per cell
+    double cells = 0.0;
+    double nominal_flops_per_cell = 0.0;
+};
+
+/*
+  Times named kernels (fencing before and after each) and reads the hardware
+  counters around them. The report gives, per kernel: time per call,
+  instructions per cycle, memory traffic per cell (last level cache misses
+  times the line size: lines brought in by the hardware prefetchers are not
+  counted as misses, so this is a lower bound on the DRAM traffic, and the
+  intensity an upper bound) and the roofline position (arithmetic intensity
+  and achieved FLOP rate, and the attainable fraction if the machine peaks
+  are given). Counters are CPU counters: for device kernels only the host side is
+  counted, and the timing is the useful measurement.
+*/
+class KernelProfile
+{
+  public:
+    KernelProfile( const bool counters = true, const std::uint64_t fp_event = 0,
+                   const double line_size = 64.0 )
+        : counters_( counters, fp_event )
+        , line_size_( line_size )
+    {
+    }
+
+    // Run and measure a kernel over the given number of cells
+    template <class ExecutionSpace, class Function>
+    void measure( ExecutionSpace exec_space, const std::string& name,
+                  const double cells, const double nominal_flops_per_cell,
+                  Function&& kernel )
+    {
+        exec_space.fence();
+        counters_.start();
+        auto start = std::chrono::high_resolution_clock::now();
+
+        kernel();
+        exec_space.fence();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        auto counts = counters_.stop();
+
+        auto& kernel_counts = kernels_[name];
+        kernel_counts.calls++;
+        kernel_counts.seconds +=
+            std::chrono::duration<double>( end - start ).count();
+        for ( int e = 0; e < PerfCounters::num_events; ++e )
+            kernel_counts.counts[e] += counts[e];
+        kernel_counts.cells = cells;
+        kernel_counts.nominal_flops_per_cell = nominal_flops_per_cell;
+    }
+
+    const std::map<std::string, KernelCounts>& kernels() const
+    {
+        return kernels_;
+    }
+
+    // Peak memory bandwidth (bytes/s) and floating point rate (FLOP/s)
+    void write( std::ostream& os, const double peak_bandwidth = 0.0,
+                const double peak_flops = 0.0 ) const
+    {
+        bool cycles = counters_.available( PerfCounters::cycles ) &&
+                      counters_.available( PerfCounters::instructions );
+        bool traffic = counters_.available( PerfCounters::llc_misses );
+        bool fp = counters_.available( PerfCounters::fp_ops );
+
+        os << "Kernel profile";
+        if ( !cycles && !traffic )
+            os << " (hardware counters unavailable: timing only)";
+        os << ":" << std::endl;
+
+        for ( const auto& [name, k] : kernels_ )
+        {
+            double cell_updates = k.cells * k.calls;
+            os << "  " << name << ": " << k.calls << " calls, "
+               << std::scientific << std::setprecision( 3 )
+               << k.seconds / k.calls << " s/call, "
+               << cell_updates / k.seconds << " cells/s";
+
+            if ( cycles && k.counts[PerfCounters::cycles] > 0 )
+                os << ", IPC " << std::fixed << std::setprecision( 2 )
+                   << static_cast<double>(
+                          k.counts[PerfCounters::instructions] ) /
+                          k.counts[PerfCounters::cycles];
+
+            double bytes = 0.0;
+            if ( traffic && cell_updates > 0.0 )
+            {
+                bytes = k.counts[PerfCounters::llc_misses] * line_size_;
+                os << ", " << std::fixed << std::setprecision( 2 )
+                   << bytes / cell_updates << " B/cell (LLC misses)";
+            }
+
+            double flops = fp ? k.counts[PerfCounters::fp_ops]
+                              : k.nominal_flops_per_cell * cell_updates;
+            if ( flops > 0.0 && bytes > 0.0 )
+            {
+                double intensity = flops / bytes;
+                double rate = flops / k.seconds;
+                os << ", " << std::fixed << std::setprecision( 3 ) << intensity
+                   << ( fp ? "" : " (nominal)" ) << " FLOP/B, "
+                   << std::scientific << std::setprecision( 3 ) << rate
+                   << " FLOP/s";
+                if ( peak_bandwidth > 0.0 && peak_flops > 0.0 )
+                {
+                    double attainable =
+                        std::min( peak_flops, intensity * peak_bandwidth );
+                    os << " (" << std::fixed << std::setprecision( 1 )
+                       << 100.0 * rate / attainable << "% of the "
+                       << ( intensity * peak_bandwidth < peak_flops
+                                ? "memory"
+                                : "compute" )
+                       << " roof)";
+                }
+            }
+            os << std::defaultfloat << std::endl;
+        }
+    }
+
+  protected:
+    PerfCounters counters_;
+    double line_size_;
+    std::map<std::string, KernelCounts> kernels_;
+};
+
+} // namespace Finch
+
+#endif
@@ -12,18 +12,38 @@
 #ifndef Layer_H
 #define Layer_H
 
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include <Cabana_Grid.hpp>
 #include <Kokkos_Core.hpp>
 
+#include "Finch_Activation.hpp"
+#include "Finch_EnergyMonitor.hpp"
 #include "Finch_Grid.hpp"
+#include "Finch_ImexSolver.hpp"
 #include "Finch_Inputs.hpp"
+#include "Finch_Observers.hpp"
 #include "Finch_SolidificationData.hpp"
 #include "Finch_Solver.hpp"
+#include "Finch_SpectralSolver.hpp"
 #include "MovingBeam/Finch_MovingBeam.hpp"
 
 namespace Finch
 {
 
+// Run each phase of a time step directly (see Layer::step)
+struct RunPhase
+{
+    template <class Function>
+    void operator()( const std::string&, Function&& phase ) const
+    {
+        phase();
+    }
+};
+
 template <typename MemorySpace>
 class Layer
 {
@@ -31,6 +51,7 @@ class Layer
     using memory_space = MemorySpace;
     using sampling_type = Finch::SolidificationData<memory_space>;
     sampling_type solidification_data_;
+    Activation<memory_space> activation_;
 
     Layer( Inputs& inputs, Grid<MemorySpace>& grid )
     {
@@ -38,44 +59,80 @@ class Layer
         // return from any member functions
         if ( inputs.sampling.enabled )
             solidification_data_ = sampling_type( inputs, grid );
+        if ( inputs.deposition.enabled )
+            activation_ = Activation<memory_space>( inputs, grid );
     }
 
-    // Run the full timestepped loop
-    template <typename ExecutionSpace, typename SolverType>
+    // Run the full timestepped loop (for a single beam or a beam per member),
+    // calling the time and energy monitors, field output and any additional
+    // observers after each step
+    template <typename ExecutionSpace, typename BeamType, typename SolverType,
+              typename... Observers>
     void run( ExecutionSpace exec_space, Inputs& inputs,
-              Grid<MemorySpace>& grid, MovingBeam& beam, SolverType& fd )
+              Grid<MemorySpace>& grid, BeamType& beam, SolverType& fd,
+              Observers&&... observers )
     {
         // time stepping
         double& time = inputs.time.time;
         int num_steps = inputs.time.num_steps;
         double dt = inputs.time.time_step;
-        int output_interval = inputs.time.output.interval;
+
+        TimeMonitorObserver monitor( inputs );
+        FieldOutputObserver output( inputs );
+        EnergyMonitorObserver<MemorySpace> energy( inputs, grid );
 
         // update the temperature field
         for ( int n = 0; n < num_steps; ++n )
         {
             inputs.time_monitor.update();
 
-            step( exec_space, time, dt, grid, beam, fd );
+            // Linear solvers may combine several steps into one
+            int combined = combinedSteps( inputs, grid, beam, fd, n );
+            step( exec_space, time, combined * dt, grid, beam, fd );
+            int last = n + combined - 1;
 
-            // Update time monitoring
-            if ( ( n + 1 ) % inputs.time.monitor.interval == 0 )
-            {
-                inputs.time_monitor.write( n );
-            }
+            StepContext<Grid<MemorySpace>, BeamType, SolverType> context{
+                last, time, combined * dt, inputs, grid, beam, fd };
+            observe( context, n, monitor, energy, output, observers... );
 
-            // Write the current temperature field
-            if ( ( n + 1 ) % output_interval == 0 )
-            {
-                grid.output( n, n * dt );
-            }
+            n = last;
         }
     }
 
-    // Run a single timestep
-    template <typename ExecutionSpace, typename SolverType>
+    // Number of time steps to take at once. The spectral solver is exact for
+    // any interval, so once the beam is off and the domain is below the
+    // liquidus (no further solidification events can occur until the beam
+    // turns back on) the whole power-off interval is a single step.
+    template <typename BeamType, typename SolverType>
+    int combinedSteps( Inputs& inputs, Grid<MemorySpace>& grid, BeamType& beam,
+                       SolverType&, const int n )
+    {
+        if constexpr ( isSpectralSolver<SolverType>::value &&
+                       std::is_same<BeamType, MovingBeam>::value )
+        {
+            double time = inputs.time.time;
+            double dt = inputs.time.time_step;
+            int remaining = inputs.time.num_steps - n;
+
+            double off_steps =
+                std::floor( ( beam.nextPowerOnTime( time ) - time ) / dt );
+            int steps = ( off_steps < remaining )
+                            ? static_cast<int>( off_steps )
+                            : remaining;
+            if ( steps > 1 &&
+                 grid.maxTemperature() < inputs.properties.liquidus )
+                return steps;
+        }
+        return 1;
+    }
+
+    // Run a single timestep. The solve, boundary, halo and solidification
+    // phases are each run through the given runner (e.g. to time them).
+    template <typename ExecutionSpace, typename SolverType,
+              typename PhaseRunner = RunPhase>
     void step( ExecutionSpace exec_space, double& time, const double dt,
-               Grid<MemorySpace> grid, MovingBeam& beam, SolverType& fd )
+               Grid<MemorySpace>& grid, MovingBeam& beam, SolverType& fd,
+               PhaseRunner run_phase = PhaseRunner{} )
     {
         time += dt;
 
@@ -85,17 +142,88 @@ class Layer
         double beam_pos[3];
         for ( std::size_t d = 0; d < 3; ++d )
             beam_pos[d] = beam.position( d );
+        if ( beam_power > 0.0 )
+            solidification_data_.addSource( beam_pos );
+
+        // deposit material under the beam
+        activation_.update( beam_pos, beam_power );
+
+        // store previous value for explicit update
+        grid.swapTemperature();
 
         // Get temperature views;
         auto T = grid.getTemperature();
         auto T0 = grid.getPreviousTemperature();
 
+        // Solve finite difference (or spectral, over the full interval)
+        auto owned_space = grid.getIndexSpace();
+        run_phase( "solve",
+                   [&]()
+                   {
+                       if constexpr ( isSpectralSolver<SolverType>::value )
+                           fd.solve( exec_space, owned_space, T, T0,
+                                     beam_power, beam_pos, dt );
+                       else if constexpr ( isImexSolver<SolverType>::value )
+                           fd.solve( exec_space, owned_space, T, T0,
+                                     beam_power, beam_pos );
+                       else if ( activation_.enabled() )
+                           fd.solve( exec_space, activation_.space(), T, T0,
+                                     beam_power, beam_pos,
+                                     activation_.mask() );
+                       else
+                           fd.solve( exec_space, owned_space, T, T0,
+                                     beam_power, beam_pos );
+                   } );
+
+        // update boundaries
+        run_phase( "boundary", [&]() { grid.updateBoundaries(); } );
+
+        // communicate halos
+        run_phase( "halo", [&]() { grid.gather(); } );
+
+        // The spectral and imex solvers are not local: any cell may cross the
+        // liquidus
+        run_phase( "solidification",
+                   [&]()
+                   {
+                       solidification_data_.update(
+                           grid, time,
+                           !isSpectralSolver<SolverType>::value &&
+                               !isImexSolver<SolverType>::value );
+                   } );
+    }
+
+    // Run a single timestep for an ensemble with one beam per member
+    template <typename ExecutionSpace, typename SolverType>
+    void step( ExecutionSpace exec_space, double& time, const double dt,
+               Grid<MemorySpace>& grid, std::vector<MovingBeam>& beams,
+               SolverType& fd )
+    {
+        time += dt;
+
+        // update beam positions
+        for ( auto& beam : beams )
+        {
+            beam.move( time );
+            if ( beam.power() > 0.0 )
+            {
+                double beam_pos[3];
+                for ( std::size_t d = 0; d < 3; ++d )
+                    beam_pos[d] = beam.position( d );
+                solidification_data_.addSource( beam_pos );
+            }
+        }
+
         // store previous value for explicit update
-        Kokkos::deep_copy( T0, T );
+        grid.swapTemperature();
+
+        // Get temperature views;
+        auto T = grid.getTemperature();
+        auto T0 = grid.getPreviousTemperature();
 
-        // Solve finite difference
+        // Solve finite difference for all members
         auto owned_space = grid.getIndexSpace();
-        fd.solve( exec_space, owned_space, T, T0, beam_power, beam_pos );
+        fd.solve( exec_space, owned_space, T, T0, beams );
 
         // update boundaries
         grid.updateBoundaries();
@@ -103,7 +231,7 @@ class Layer
         // communicate halos
         grid.gather();
 
-        solidification_data_.update( grid, time );
+        solidification_data_.update( grid, time, true );
     }
 
     auto getSolidificationData() { return solidification_data_.get(); }
@@ -18,8 +18,10 @@
 #ifndef SolidificationData_H
 #define SolidificationData_H
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <math.h>
 #include <mpi.h>
@@ -35,6 +37,33 @@
 namespace Finch
 {
 
+// Write events (host view, one per row) in the sampling format.
+template <typename HostViewType>
+void writeEvents( std::ostream& fout, const HostViewType& events_host,
+                  const int count, const std::string& format,
+                  const int num_members )
+{
+    for ( int n = 0; n < count; n++ )
+    {
+        fout << events_host( n, 0 ) << "," << events_host( n, 1 ) << ","
+             << events_host( n, 2 ) << "," << events_host( n, 3 ) << ","
+             << events_host( n, 4 ) << "," << events_host( n, 5 );
+
+        if ( format == "default" )
+        {
+            fout << "," << events_host( n, 6 ) << "," << events_host( n, 7 )
+                 << "," << events_host( n, 8 );
+        }
+
+        if ( num_members > 1 )
+        {
+            fout << "," << static_cast<int>( events_host( n, 9 ) );
+        }
+
+        fout << std::endl;
+    }
+}
+
 template <typename MemorySpace>
 class SolidificationData
 {
@@ -43,6 +72,7 @@ class SolidificationData
     using view_int = Kokkos::View<int*, memory_space>;
     using view_double2D = Kokkos::View<double**, memory_space>;
     using view_double4D = Kokkos::View<double****, memory_space>;
+    using view_type = typename Grid<memory_space>::view_type;
     using view_type_coupled =
         Kokkos::View<double**, Kokkos::LayoutLeft, Kokkos::HostSpace>;
 
@@ -55,6 +85,7 @@ class SolidificationData
     double cell_size_;
     bool enabled_;
     std::string format_;
+    int num_members_;
 
     view_int count;
 
@@ -66,6 +97,38 @@ class SolidificationData
 
     view_double4D tm_view;
 
+    // Events are detected every interval_ steps (the sampling window), by
+    // comparing with the temperature at the start of the window: the previous
+    // temperature, or a lagged snapshot kept for the cells in the liquid box
+    // (stored from lag_offset_, including the neighbors for gradients).
+    int interval_;
+    int steps_in_window_;
+    view_type lag_view_;
+    Kokkos::Array<long, 3> lag_min_;
+    Kokkos::Array<long, 3> lag_max_;
+    Kokkos::Array<long, 3> lag_offset_;
+
+    // Start temperature of the previous window, for the cells liquid at the
+    // start of both windows (central difference cooling rates), stored from
+    // history_min_. Both snapshots only cover the liquid box and grow as
+    // needed.
+    view_type history_view_;
+    Kokkos::Array<long, 3> history_min_;
+    Kokkos::Array<long, 3> history_max_;
+
+    // Local index region of the cells which may cross the liquidus in the
+    // window: the liquid cells at its start (including those next to liquid
+    // ghost cells) and the heat source regions, expanded by the stencil width
+    // for each step. Without an external source the explicit update is bounded
+    // by its neighbors, so no other cell can melt or solidify.
+    view_int liquid_box_;
+    std::array<long, 3> region_min_;
+    std::array<long, 3> region_max_;
+    Cabana::Grid::IndexSpace<3> owned_space_;
+    Kokkos::Array<Cabana::Grid::IndexSpace<3>, 6> halo_spaces_;
+    std::array<double, 3> owned_low_corner_;
+    std::array<double, 3> source_extent_;
+
   public:
     // Default constructor
     SolidificationData() {}
@@ -78,13 +141,17 @@ class SolidificationData
         , cell_size_( inputs.space.cell_size )
         , enabled_( inputs.sampling.enabled )
         , format_( inputs.sampling.format )
+        , num_members_( inputs.members.size )
+        , interval_( inputs.sampling.interval )
+        , steps_in_window_( 0 )
     {
         count = view_int( "count", 1 );
 
-        capacity = round( grid.getIndexSpace().size() );
+        capacity = round( grid.getIndexSpace().size() * num_members_ );
 
-        // components: x, y, z, tm, ts, R, Gx, Gy, Gz
-        nCmpts = 9;
+        // components: x, y, z, tm, ts, R, Gx, Gy, Gz (and member index for
+        // ensembles)
+        nCmpts = ( num_members_ > 1 ) ? 10 : 9;
 
         events =
             view_double2D( Kokkos::ViewAllocateWithoutInitializing( "events" ),
@@ -92,14 +159,183 @@ class SolidificationData
 
         auto local_grid = grid.getLocalGrid();
         using entity_type = typename Grid<memory_space>::entity_type;
-        auto layout =
-            Cabana::Grid::createArrayLayout( local_grid, 1, entity_type() );
+        auto layout = Cabana::Grid::createArrayLayout(
+            local_grid, num_members_, entity_type() );
         auto tm =
             Cabana::Grid::createArray<double, memory_space>( "tm", layout );
         tm_view = tm->view();
+
+        // Cells already liquid at the start (e.g. a parareal slice starting
+        // mid-melt) melted no later than the start time
+        if ( enabled_ )
+        {
+            auto T = grid.getTemperature();
+            auto tm_start = tm_view;
+            double liquidus = liquidus_;
+            double start_time = inputs.time.start_time;
+            int num_members = num_members_;
+            Cabana::Grid::grid_parallel_for(
+                "seed_melting_time", exec_space(), grid.getIndexSpace(),
+                KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                    for ( int e = 0; e < num_members; ++e )
+                        if ( T( i, j, k, e ) > liquidus )
+                            tm_start( i, j, k, e ) = start_time;
+                } );
+        }
+
+        // The initial state is unknown: detect over all owned cells first
+        liquid_box_ = view_int( "liquid_box", 6 );
+        owned_space_ = grid.getIndexSpace();
+        auto local_mesh = grid.getLocalMesh();
+        int count_planes = 0;
+        for ( int d = 0; d < 3; ++d )
+        {
+            region_min_[d] = owned_space_.min( d );
+            region_max_[d] = owned_space_.max( d );
+            lag_min_[d] = owned_space_.min( d );
+            lag_max_[d] = owned_space_.max( d );
+            lag_offset_[d] = 0;
+            history_min_[d] = owned_space_.max( d );
+            history_max_[d] = owned_space_.min( d );
+            owned_low_corner_[d] =
+                local_mesh.lowCorner( Cabana::Grid::Own(), d );
+
+            // Cut off of the source term (as in the solver)
+            double r = inputs.source.two_sigma[d] / Kokkos::sqrt( 2.0 );
+            source_extent_[d] =
+                r * Kokkos::sqrt( Kokkos::log( 3 ) + 2 * Kokkos::log( 10 ) );
+
+            // Ghost planes on either side (from neighboring ranks or
+            // boundary conditions)
+            for ( int dir = -1; dir < 2; dir += 2 )
+            {
+                std::array<long, 3> min, max;
+                for ( int e = 0; e < 3; ++e )
+                {
+                    min[e] = owned_space_.min( e );
+                    max[e] = owned_space_.max( e );
+                }
+                min[d] = ( dir < 0 ) ? min[d] - 1 : max[d];
+                max[d] = min[d] + 1;
+                halo_spaces_[count_planes++] =
+                    Cabana::Grid::IndexSpace<3>( min, max );
+            }
+        }
+
+        // Start of the first window: keep the cells liquid initially
+        if ( enabled_ && interval_ > 1 )
+        {
+            auto T = grid.getTemperature();
+            resetLiquidBox();
+            Cabana::Grid::grid_parallel_for(
+                "initial_liquid", exec_space(), owned_space_,
+                KOKKOS_CLASS_LAMBDA( const int i, const int j, const int k ) {
+                    for ( int e = 0; e < num_members_; ++e )
+                        if ( T( i, j, k, e ) > liquidus_ )
+                            addLiquid( i, j, k );
+                } );
+            auto box_host = Kokkos::create_mirror_view_and_copy(
+                Kokkos::HostSpace(), liquid_box_ );
+            std::array<long, 3> min, max;
+            for ( int d = 0; d < 3; ++d )
+            {
+                min[d] = owned_space_.max( d );
+                max[d] = owned_space_.min( d );
+            }
+            if ( box_host( 0 ) <= box_host( 3 ) )
+            {
+                for ( int d = 0; d < 3; ++d )
+                {
+                    min[d] = box_host( d );
+                    max[d] = box_host( d + 3 ) + 1;
+                }
+            }
+            updateLag( grid, min, max );
+        }
+    }
+
+    // Include the region heated by a beam at this position in the detection
+    // for the current step.
+    void addSource( const double position[3] )
+    {
+        if ( !enabled_ )
+            return;
+
+        std::array<long, 3> min, max;
+        for ( int d = 0; d < 3; ++d )
+        {
+            double low = position[d] - source_extent_[d] - owned_low_corner_[d];
+            double high =
+                position[d] + source_extent_[d] - owned_low_corner_[d];
+            min[d] = std::max( owned_space_.min( d ) +
+                                   static_cast<long>(
+                                       std::floor( low / cell_size_ ) ),
+                               owned_space_.min( d ) );
+            max[d] = std::min( owned_space_.min( d ) +
+                                   static_cast<long>(
+                                       std::ceil( high / cell_size_ ) ) +
+                                   1,
+                               owned_space_.max( d ) );
+            // Source outside of this rank
+            if ( min[d] >= max[d] )
+                return;
+        }
+
+        addRegion( min, max );
+    }
+
+    void addRegion( const std::array<long, 3>& min,
+                    const std::array<long, 3>& max )
+    {
+        bool empty = regionEmpty();
+        for ( int d = 0; d < 3; ++d )
+        {
+            region_min_[d] =
+                empty ? min[d] : std::min( region_min_[d], min[d] );
+            region_max_[d] =
+                empty ? max[d] : std::max( region_max_[d], max[d] );
+        }
     }
 
-    void updateEvents( Grid<memory_space>& grid, const double time )
+    // Cells which may cross the liquidus in the current window
+    Cabana::Grid::IndexSpace<3> detectionSpace() const
+    {
+        std::array<long, 3> min, max;
+        for ( int d = 0; d < 3; ++d )
+        {
+            min[d] = std::max( region_min_[d] - interval_,
+                               owned_space_.min( d ) );
+            max[d] = std::min( region_max_[d] + interval_,
+                               owned_space_.max( d ) );
+        }
+        return Cabana::Grid::IndexSpace<3>( min, max );
+    }
+
+    bool regionEmpty() const
+    {
+        for ( int d = 0; d < 3; ++d )
+            if ( region_min_[d] >= region_max_[d] )
+                return true;
+        return false;
+    }
+
+    // Add the liquid box (inclusive indices) recorded on the device
+    template <class BoxViewType>
+    void addLiquidRegion( const BoxViewType& box_host )
+    {
+        if ( box_host( 0 ) > box_host( 3 ) )
+            return;
+        std::array<long, 3> min, max;
+        for ( int d = 0; d < 3; ++d )
+        {
+            min[d] = box_host( d );
+            max[d] = box_host( d + 3 ) + 1;
+        }
+        addRegion( min, max );
+    }
+
+    void updateEvents( Grid<memory_space>& grid, const double time,
+                       const Cabana::Grid::IndexSpace<3>& space )
     {
         // get local copies from grid
         auto local_mesh = grid.getLocalMesh();
@@ -108,101 +344,345 @@ class SolidificationData
 
         using entity_type = typename Grid<memory_space>::entity_type;
 
+        // Temperature at the start of the window, known for the cells in the
+        // lagged box. Other cells were not liquid then: melting is found from
+        // the previous temperature, extrapolating back over the window.
+        auto T_start = ( interval_ > 1 ) ? lag_view_ : T0;
+        Kokkos::Array<long, 3> offset = { 0, 0, 0 };
+        if ( interval_ > 1 )
+            offset = lag_offset_;
+        double window = interval_ * dt_;
+
         Cabana::Grid::grid_parallel_for(
-            "local_grid_for", exec_space(), grid.getIndexSpace(),
+            "local_grid_for", exec_space(), space,
             KOKKOS_CLASS_LAMBDA( const int i, const int j, const int k ) {
-                double temp = T( i, j, k, 0 );
-                double temp0 = T0( i, j, k, 0 );
-
-                if ( ( temp <= liquidus_ ) && ( temp0 > liquidus_ ) )
+                bool known = ( i >= lag_min_[0] && i < lag_max_[0] &&
+                               j >= lag_min_[1] && j < lag_max_[1] &&
+                               k >= lag_min_[2] && k < lag_max_[2] );
+                bool history =
+                    ( i >= history_min_[0] && i < history_max_[0] &&
+                      j >= history_min_[1] && j < history_max_[1] &&
+                      k >= history_min_[2] && k < history_max_[2] );
+                double duration = known ? window : dt_;
+                double max_m = known ? 1.0 : interval_;
+
+                for ( int e = 0; e < num_members_; ++e )
                 {
-                    int current_count =
-                        Kokkos::atomic_fetch_add( &count( 0 ), 1 );
+                    double temp = T( i, j, k, e );
+                    double temp0 =
+                        known ? T_start( i - offset[0], j - offset[1],
+                                         k - offset[2], e )
+                              : T0( i, j, k, e );
 
-                    if ( current_count < capacity )
+                    if ( temp > liquidus_ )
+                        addLiquid( i, j, k );
+
+                    if ( known && ( temp <= liquidus_ ) &&
+                         ( temp0 > liquidus_ ) )
                     {
-                        // event coordinates
-                        double pt[3];
-                        int idx[3] = { i, j, k };
-                        local_mesh.coordinates( entity_type(), idx, pt );
-                        events( current_count, 0 ) = pt[0];
-                        events( current_count, 1 ) = pt[1];
-                        events( current_count, 2 ) = pt[2];
-
-                        // event melting time
-                        events( current_count, 3 ) = tm_view( i, j, k, 0 );
-
-                        // event solidification time
-                        double m = ( temp - liquidus_ ) / ( temp - temp0 );
-                        m = fmin( fmax( m, 0.0 ), 1.0 );
-                        events( current_count, 4 ) = time - m * dt_;
-
-                        // cooling rate
-                        events( current_count, 5 ) = ( temp0 - temp ) / dt_;
-
-                        // temperature gradient components
-                        events( current_count, 6 ) =
-                            ( T( i + 1, j, k, 0 ) - T( i - 1, j, k, 0 ) ) /
-                            ( 2.0 * cell_size_ );
-
-                        events( current_count, 7 ) =
-                            ( T( i, j + 1, k, 0 ) - T( i, j - 1, k, 0 ) ) /
-                            ( 2.0 * cell_size_ );
-
-                        events( current_count, 8 ) =
-                            ( T( i, j, k + 1, 0 ) - T( i, j, k - 1, 0 ) ) /
-                            ( 2.0 * cell_size_ );
+                        int current_count =
+                            Kokkos::atomic_fetch_add( &count( 0 ), 1 );
+
+                        if ( current_count < capacity )
+                        {
+                            // event coordinates
+                            double pt[3];
+                            int idx[3] = { i, j, k };
+                            local_mesh.coordinates( entity_type(), idx, pt );
+                            events( current_count, 0 ) = pt[0];
+                            events( current_count, 1 ) = pt[1];
+                            events( current_count, 2 ) = pt[2];
+
+                            // event melting time
+                            events( current_count, 3 ) = tm_view( i, j, k, e );
+
+                            // event solidification time
+                            double m = ( temp - liquidus_ ) / ( temp - temp0 );
+                            m = fmin( fmax( m, 0.0 ), 1.0 );
+                            events( current_count, 4 ) = time - m * duration;
+
+                            // cooling rate: central difference over the
+                            // last three samples, i.e. at the last one above
+                            // the liquidus (latent heat release makes it
+                            // discontinuous at the crossing), or the one
+                            // sided difference without history
+                            events( current_count, 5 ) =
+                                history ? ( history_view_(
+                                                i - history_min_[0],
+                                                j - history_min_[1],
+                                                k - history_min_[2], e ) -
+                                            temp ) /
+                                              ( 2.0 * duration )
+                                        : ( temp0 - temp ) / duration;
+
+                            // temperature gradient components at the
+                            // crossing
+                            int idx_lo[3] = { i, j, k };
+                            int idx_hi[3] = { i, j, k };
+                            for ( int d = 0; d < 3; ++d )
+                            {
+                                idx_lo[d] -= 1;
+                                idx_hi[d] += 1;
+                                double g =
+                                    T( idx_hi[0], idx_hi[1], idx_hi[2], e ) -
+                                    T( idx_lo[0], idx_lo[1], idx_lo[2], e );
+                                double g0 =
+                                    T_start( idx_hi[0] - offset[0],
+                                             idx_hi[1] - offset[1],
+                                             idx_hi[2] - offset[2], e ) -
+                                    T_start( idx_lo[0] - offset[0],
+                                             idx_lo[1] - offset[1],
+                                             idx_lo[2] - offset[2], e );
+                                events( current_count, 6 + d ) =
+                                    ( ( 1.0 - m ) * g + m * g0 ) /
+                                    ( 2.0 * cell_size_ );
+                                idx_lo[d] += 1;
+                                idx_hi[d] -= 1;
+                            }
+
+                            // ensemble member
+                            if ( num_members_ > 1 )
+                                events( current_count, 9 ) = e;
+                        }
+                    }
+                    else if ( ( temp > liquidus_ ) &&
+                              ( temp0 <= liquidus_ || !known ) )
+                    {
+                        double m = ( temp > temp0 )
+                                       ? ( temp - liquidus_ ) / ( temp - temp0 )
+                                       : max_m;
+                        m = fmin( fmax( m, 0.0 ), max_m );
+                        tm_view( i, j, k, e ) = time - m * duration;
                     }
-                }
-                else if ( ( temp > liquidus_ ) && ( temp0 <= liquidus_ ) )
-                {
-                    double m = ( temp - liquidus_ ) / ( temp - temp0 );
-                    m = fmin( fmax( m, 0.0 ), 1.0 );
-                    tm_view( i, j, k, 0 ) = time - m * dt_;
                 }
             } );
     }
 
-    // Update the solidification data
-    void update( Grid<memory_space>& grid, const double time )
+    // Extend the liquid box to include a cell
+    KOKKOS_INLINE_FUNCTION void addLiquid( const int i, const int j,
+                                           const int k ) const
+    {
+        int idx[3] = { i, j, k };
+        for ( int d = 0; d < 3; ++d )
+        {
+            if ( idx[d] < liquid_box_( d ) )
+                Kokkos::atomic_min( &liquid_box_( d ), idx[d] );
+            if ( idx[d] > liquid_box_( d + 3 ) )
+                Kokkos::atomic_max( &liquid_box_( d + 3 ), idx[d] );
+        }
+    }
+
+    // Owned cells next to liquid ghost cells may melt in the next step
+    void updateHaloLiquid( Grid<memory_space>& grid )
+    {
+        auto T = grid.getTemperature();
+        auto owned = owned_space_;
+        Cabana::Grid::grid_parallel_for(
+            "halo_liquid", exec_space(), halo_spaces_,
+            KOKKOS_CLASS_LAMBDA( const int, const int i, const int j,
+                                 const int k ) {
+                for ( int e = 0; e < num_members_; ++e )
+                    if ( T( i, j, k, e ) > liquidus_ )
+                        addLiquid(
+                            Kokkos::min( Kokkos::max( i, int( owned.min( 0 ) ) ),
+                                         int( owned.max( 0 ) - 1 ) ),
+                            Kokkos::min( Kokkos::max( j, int( owned.min( 1 ) ) ),
+                                         int( owned.max( 1 ) - 1 ) ),
+                            Kokkos::min( Kokkos::max( k, int( owned.min( 2 ) ) ),
+                                         int( owned.max( 2 ) - 1 ) ) );
+            } );
+    }
+
+    // Update the solidification data (every sampling interval). If bounded
+    // (for solvers with a local stencil), only the cells which may have
+    // crossed the liquidus are checked.
+    void update( Grid<memory_space>& grid, const double time,
+                 const bool bounded = false )
     {
         if ( !enabled_ )
         {
             return;
         }
 
-        auto count_old_host =
-            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), count );
+        auto box_host = Kokkos::create_mirror_view( liquid_box_ );
 
-        updateEvents( grid, time );
+        // Within the window only track liquid ghost cells (heat source regions
+        // are added separately)
+        if ( ++steps_in_window_ < interval_ )
+        {
+            if ( bounded )
+                updateHaloLiquid( grid );
+            return;
+        }
+        steps_in_window_ = 0;
+        if ( bounded && interval_ > 1 )
+        {
+            Kokkos::deep_copy( box_host, liquid_box_ );
+            addLiquidRegion( box_host );
+        }
 
-        auto count_host =
-            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), count );
+        auto space = bounded ? detectionSpace() : owned_space_;
+        bool empty = bounded && regionEmpty();
 
-        int new_count = count_host( 0 );
+        resetLiquidBox();
 
-        // more events were added than the current view capacity.
-        // resize view and update events starting from the previous counter.
-        if ( new_count >= capacity )
+        if ( !empty )
         {
-            capacity = 2.0 * new_count;
+            auto count_old_host = Kokkos::create_mirror_view_and_copy(
+                Kokkos::HostSpace(), count );
 
-            Kokkos::resize( Kokkos::WithoutInitializing, events, capacity,
-                            nCmpts );
+            updateEvents( grid, time, space );
 
-            Kokkos::deep_copy( count, count_old_host( 0 ) );
+            auto count_host = Kokkos::create_mirror_view_and_copy(
+                Kokkos::HostSpace(), count );
 
-            updateEvents( grid, time );
+            int new_count = count_host( 0 );
+
+            // more events were added than the current view capacity.
+            // resize view and update events starting from the previous
+            // counter.
+            if ( new_count >= capacity )
+            {
+                capacity = 2.0 * new_count;
+
+                Kokkos::resize( Kokkos::WithoutInitializing, events, capacity,
+                                nCmpts );
+
+                Kokkos::deep_copy( count, count_old_host( 0 ) );
+
+                updateEvents( grid, time, space );
+            }
+
+            // view size is within 90% of capacity. double current size.
+            else if ( new_count / capacity > 0.9 )
+            {
+                capacity = 2.0 * new_count;
+
+                Kokkos::resize( Kokkos::WithoutInitializing, events, capacity,
+                                nCmpts );
+            }
         }
 
-        // view size is within 90% of capacity. double current size.
-        else if ( new_count / capacity > 0.9 )
+        // Start of the next window: the liquid cells
+        updateHaloLiquid( grid );
+        Kokkos::deep_copy( box_host, liquid_box_ );
+        for ( int d = 0; d < 3; ++d )
         {
-            capacity = 2.0 * new_count;
+            region_min_[d] = owned_space_.max( d );
+            region_max_[d] = owned_space_.min( d );
+        }
+        addLiquidRegion( box_host );
+        updateHistory( grid );
+        if ( interval_ > 1 )
+            updateLag( grid, region_min_, region_max_ );
+    }
+
+    // Empty the liquid box recorded on the device
+    void resetLiquidBox()
+    {
+        auto box_host = Kokkos::create_mirror_view( liquid_box_ );
+        for ( int d = 0; d < 3; ++d )
+        {
+            box_host( d ) = owned_space_.max( d );
+            box_host( d + 3 ) = owned_space_.min( d ) - 1;
+        }
+        Kokkos::deep_copy( liquid_box_, box_host );
+    }
 
-            Kokkos::resize( Kokkos::WithoutInitializing, events, capacity,
-                            nCmpts );
+    // Make sure a snapshot holds at least the given index box
+    void reserve( view_type& view, const std::string& label,
+                  const std::array<long, 3>& min,
+                  const std::array<long, 3>& max )
+    {
+        long extent[3];
+        bool grow = false;
+        for ( int d = 0; d < 3; ++d )
+        {
+            extent[d] = std::max( static_cast<long>( view.extent( d ) ),
+                                  max[d] - min[d] );
+            grow = grow || extent[d] > static_cast<long>( view.extent( d ) );
         }
+        if ( grow )
+            view = view_type( Kokkos::ViewAllocateWithoutInitializing( label ),
+                              extent[0], extent[1], extent[2], num_members_ );
+    }
+
+    // Keep the start temperature of this window for the liquid cells which
+    // were also known at its start
+    void updateHistory( Grid<memory_space>& grid )
+    {
+        std::array<long, 3> min, max;
+        bool empty = false;
+        for ( int d = 0; d < 3; ++d )
+        {
+            min[d] = std::max( region_min_[d], lag_min_[d] );
+            max[d] = std::min( region_max_[d], lag_max_[d] );
+            empty = empty || ( min[d] >= max[d] );
+        }
+        for ( int d = 0; d < 3; ++d )
+        {
+            history_min_[d] = empty ? owned_space_.max( d ) : min[d];
+            history_max_[d] = empty ? owned_space_.min( d ) : max[d];
+        }
+        if ( empty )
+            return;
+
+        reserve( history_view_, "T_hist", min, max );
+        auto T_start =
+            ( interval_ > 1 ) ? lag_view_ : grid.getPreviousTemperature();
+        Kokkos::Array<long, 3> offset = { 0, 0, 0 };
+        if ( interval_ > 1 )
+            offset = lag_offset_;
+        auto T_hist = history_view_;
+        auto hist_min = history_min_;
+        int num_members = num_members_;
+        Cabana::Grid::grid_parallel_for(
+            "history_temperature", exec_space(),
+            Cabana::Grid::IndexSpace<3>( min, max ),
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                for ( int e = 0; e < num_members; ++e )
+                    T_hist( i - hist_min[0], j - hist_min[1], k - hist_min[2],
+                            e ) = T_start( i - offset[0], j - offset[1],
+                                           k - offset[2], e );
+            } );
+    }
+
+    // Keep the temperature of the cells in the given box (the liquid cells,
+    // and their neighbors for gradients) for the next window
+    void updateLag( Grid<memory_space>& grid, const std::array<long, 3>& box_min,
+                    const std::array<long, 3>& box_max )
+    {
+        bool empty = false;
+        for ( int d = 0; d < 3; ++d )
+        {
+            lag_min_[d] = box_min[d];
+            lag_max_[d] = box_max[d];
+            empty = empty || ( box_min[d] >= box_max[d] );
+        }
+        if ( empty )
+            return;
+
+        auto T = grid.getTemperature();
+        std::array<long, 3> min, max;
+        for ( int d = 0; d < 3; ++d )
+        {
+            min[d] = std::max( box_min[d] - 1, 0L );
+            max[d] = std::min( box_max[d] + 1,
+                               static_cast<long>( T.extent( d ) ) );
+            lag_offset_[d] = min[d];
+        }
+        reserve( lag_view_, "T_lag", min, max );
+        auto T_lag = lag_view_;
+        auto offset = lag_offset_;
+        int num_members = num_members_;
+        Cabana::Grid::grid_parallel_for(
+            "lag_temperature", exec_space(),
+            Cabana::Grid::IndexSpace<3>( min, max ),
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                for ( int e = 0; e < num_members; ++e )
+                    T_lag( i - offset[0], j - offset[1], k - offset[2], e ) =
+                        T( i, j, k, e );
+            } );
     }
 
     // Return all data for the events that have been recorded during the
@@ -223,6 +703,21 @@ class SolidificationData
         return copied_data;
     }
 
+    // Return the events recorded so far in the native memory space, without
+    // copying
+    auto getEvents()
+    {
+        int num_events = 0;
+        if ( enabled_ )
+        {
+            auto count_host = Kokkos::create_mirror_view_and_copy(
+                Kokkos::HostSpace(), count );
+            num_events = count_host( 0 );
+        }
+        return Kokkos::subview( events, Kokkos::make_pair( 0, num_events ),
+                                Kokkos::ALL() );
+    }
+
     // Write the solidification data to separate files for each MPI rank
     void write( MPI_Comm comm )
     {
@@ -253,20 +748,8 @@ class SolidificationData
         fout.open( filename );
         fout << std::fixed << std::setprecision( 10 );
 
-        for ( int n = 0; n < count_host( 0 ); n++ )
-        {
-            fout << events_host( n, 0 ) << "," << events_host( n, 1 ) << ","
-                 << events_host( n, 2 ) << "," << events_host( n, 3 ) << ","
-                 << events_host( n, 4 ) << "," << events_host( n, 5 );
-
-            if ( format_ == "default" )
-            {
-                fout << "," << events_host( n, 6 ) << "," << events_host( n, 7 )
-                     << "," << events_host( n, 8 );
-            }
-
-            fout << std::endl;
-        }
+        writeEvents( fout, events_host, count_host( 0 ), format_,
+                     num_members_ );
 
         fout.close();
 
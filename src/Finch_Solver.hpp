@@ -17,6 +17,12 @@
 #ifndef Solver_H
 #define Solver_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
 #include <Cabana_Grid.hpp>
 #include <Kokkos_Core.hpp>
 
@@ -29,19 +35,67 @@ struct HostTag
 struct DeviceTag
 {
 };
+// Solve only the active (deposited) cells
+template <class SourceTag>
+struct ActiveTag
+{
+};
+
+// Source and conduction terms (W/m^3) of the cells of a solve, summed by the
+// solve kernel for the energy monitor. Summed over the owned cells, the
+// conduction of interior and rank interface faces cancels pairwise, leaving
+// the conduction through the domain boundaries.
+struct EnergyRates
+{
+    double deposited;
+    double conducted;
+
+    KOKKOS_INLINE_FUNCTION
+    EnergyRates& operator+=( const EnergyRates& other )
+    {
+        deposited += other.deposited;
+        conducted += other.conducted;
+        return *this;
+    }
+};
+
+} // namespace Finch
+
+namespace Kokkos
+{
+template <>
+struct reduction_identity<Finch::EnergyRates>
+{
+    KOKKOS_FORCEINLINE_FUNCTION static Finch::EnergyRates sum()
+    {
+        return { 0.0, 0.0 };
+    }
+};
+} // namespace Kokkos
+
+namespace Finch
+{
 
 template <typename ViewType, typename EntityType, typename LocalMeshType>
 class Solver
 {
+  public:
+    using mask_type =
+        Kokkos::View<std::uint8_t***, typename ViewType::memory_space>;
+
   protected:
     // temperature views are default constructed and updated every step.
     ViewType T_;
     ViewType T0_;
 
+    // active cell mask, set only by the masked solve
+    mask_type active_;
+
     LocalMeshType local_mesh_;
 
     // solution parameters
     double dt_;
+    double dx_;
     double solidus_;
     double liquidus_;
     double rho_cp_;
@@ -56,10 +110,17 @@ class Solver
     double I0_;
     double w_max_;
 
+    // source and conduction terms summed over the cells of the last solve,
+    // only tracked for the energy monitor
+    bool track_power_;
+    EnergyRates rates_;
+
   public:
     Solver( Inputs db, LocalMeshType local_mesh )
         : local_mesh_( local_mesh )
         , power_( 0.0 )
+        , track_power_( db.numerics.energy_monitor )
+        , rates_{ 0.0, 0.0 }
     {
         // solution parameter constants
         double dx = db.space.cell_size;
@@ -69,6 +130,8 @@ class Solver
 
         dt_ = db.time.time_step;
 
+        dx_ = dx;
+
         solidus_ = db.properties.solidus;
 
         liquidus_ = db.properties.liquidus;
@@ -105,6 +168,8 @@ class Solver
                 ViewType& T0, const double beam_power,
                 const double beam_pos[3] )
     {
+        active_ = mask_type();
+
         // Update temperature views and beam parameters for current time step
         T_ = T;
 
@@ -122,19 +187,93 @@ class Solver
 
         if constexpr ( std::is_same<memory_space, Kokkos::HostSpace>::value )
         {
-            Cabana::Grid::grid_parallel_for( "solve", exec_space, owned_space,
-                                             HostTag{}, *this );
+            launch( "solve", exec_space, owned_space, HostTag{}, *this );
         }
         else
         {
-            Cabana::Grid::grid_parallel_for( "solve", exec_space, owned_space,
-                                             DeviceTag{}, *this );
+            launch( "solve", exec_space, owned_space, DeviceTag{}, *this );
         }
     }
 
-    // Host tagged version of the temperature solver
+    // Temperature solve over the active cells only. Inactive cells keep their
+    // temperature and inactive neighbours are excluded from the stencil (an
+    // adiabatic free surface on the deposited material).
+    template <class ExecSpace, class IndexSpaceType>
+    void solve( ExecSpace exec_space, IndexSpaceType active_space,
+                ViewType& T, ViewType& T0, const double beam_power,
+                const double beam_pos[3], const mask_type& active )
+    {
+        T_ = T;
+
+        T0_ = T0;
+
+        active_ = active;
+
+        power_ = beam_power;
+
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            position_[d] = beam_pos[d];
+        }
+
+        using memory_space = typename ViewType::memory_space;
+
+        if constexpr ( std::is_same<memory_space, Kokkos::HostSpace>::value )
+        {
+            launch( "solve_active", exec_space, active_space,
+                    ActiveTag<HostTag>{}, *this );
+        }
+        else
+        {
+            launch( "solve_active", exec_space, active_space,
+                    ActiveTag<DeviceTag>{}, *this );
+        }
+    }
+
+    // Temperature solve of one cell
+    template <class Tag>
+    KOKKOS_INLINE_FUNCTION void operator()( Tag tag, const int i, const int j,
+                                            const int k ) const
+    {
+        update( tag, i, j, k );
+    }
+
+    // Temperature solve of one cell, summing the source and conduction terms
+    template <class Tag>
+    KOKKOS_INLINE_FUNCTION void operator()( Tag tag, const int i, const int j,
+                                            const int k,
+                                            EnergyRates& rates ) const
+    {
+        rates += update( tag, i, j, k );
+    }
+
+    // Active cell version of the temperature solver
+    template <class SourceTag>
+    KOKKOS_INLINE_FUNCTION EnergyRates update( ActiveTag<SourceTag>,
+                                               const int i, const int j,
+                                               const int k ) const
+    {
+        if ( !active_( i, j, k ) )
+            return { 0.0, 0.0 };
+
+        double x = T0_( i, j, k, 0 );
+
+        double dt_by_rho_cp =
+            dt_ / ( rho_cp_ +
+                    ( x >= solidus_ ) * ( x <= liquidus_ ) * rho_Lf_by_dT_ );
+
+        double q = source( SourceTag{}, i, j, k );
+        double conduction = activeLaplacian( i, j, k );
+
+        T_( i, j, k, 0 ) = x + ( conduction + q ) * dt_by_rho_cp;
+        return { q, conduction };
+    }
+
+    // Host tagged version of the temperature solver (returns the source and
+    // conduction terms)
     KOKKOS_INLINE_FUNCTION
-    void operator()( HostTag tag, const int i, const int j, const int k ) const
+    EnergyRates update( HostTag tag, const int i, const int j,
+                        const int k ) const
     {
         double x = T0_( i, j, k, 0 );
 
@@ -142,15 +281,18 @@ class Solver
                                   ? dt_ / ( rho_cp_ + rho_Lf_by_dT_ )
                                   : dt_ / ( rho_cp_ );
 
-        double rhs = laplacian( i, j, k ) + source( tag, i, j, k );
+        double q = source( tag, i, j, k );
+        double conduction = laplacian( i, j, k );
 
-        T_( i, j, k, 0 ) = x + rhs * dt_by_rho_cp;
+        T_( i, j, k, 0 ) = x + ( conduction + q ) * dt_by_rho_cp;
+        return { q, conduction };
     }
 
-    // Device tagged version of the temperature solver
+    // Device tagged version of the temperature solver (returns the source and
+    // conduction terms)
     KOKKOS_INLINE_FUNCTION
-    void operator()( DeviceTag tag, const int i, const int j,
-                     const int k ) const
+    EnergyRates update( DeviceTag tag, const int i, const int j,
+                        const int k ) const
     {
         double x = T0_( i, j, k, 0 );
 
@@ -158,11 +300,44 @@ class Solver
             dt_ / ( rho_cp_ +
                     ( x >= solidus_ ) * ( x <= liquidus_ ) * rho_Lf_by_dT_ );
 
-        double rhs = laplacian( i, j, k ) + source( tag, i, j, k );
+        double q = source( tag, i, j, k );
+        double conduction = laplacian( i, j, k );
 
-        T_( i, j, k, 0 ) = x + rhs * dt_by_rho_cp;
+        T_( i, j, k, 0 ) = x + ( conduction + q ) * dt_by_rho_cp;
+        return { q, conduction };
     }
 
+    // Power (W) added by the source term to the cells of the last solve
+    // (tracked only for the energy monitor).
+    double depositedPower() const
+    {
+        return rates_.deposited * dx_ * dx_ * dx_;
+    }
+
+    // Power (W) conducted into the cells of the last solve through the
+    // boundaries of this rank (tracked only for the energy monitor).
+    double conductedPower() const
+    {
+        return rates_.conducted * dx_ * dx_ * dx_;
+    }
+
+  protected:
+    // Launch the solve kernel of the given functor, reducing the source and
+    // conduction terms in the same pass when they are tracked.
+    template <class ExecSpace, class IndexSpaceType, class Tag, class Functor>
+    void launch( const std::string& label, ExecSpace exec_space,
+                 IndexSpaceType space, Tag tag, const Functor& functor )
+    {
+        rates_ = { 0.0, 0.0 };
+        if ( track_power_ )
+            Cabana::Grid::grid_parallel_reduce( label, exec_space, space, tag,
+                                                functor, rates_ );
+        else
+            Cabana::Grid::grid_parallel_for( label, exec_space, space, tag,
+                                             functor );
+    }
+
+  public:
     // First-order centered space laplacian stencil
     KOKKOS_INLINE_FUNCTION
     auto laplacian( const int i, const int j, const int k ) const
@@ -174,6 +349,22 @@ class Solver
                k_by_dx2_;
     }
 
+    // Laplacian over the active cells: an inactive neighbour takes the center
+    // value, so no heat flows across the free surface
+    KOKKOS_INLINE_FUNCTION
+    auto activeLaplacian( const int i, const int j, const int k ) const
+    {
+        double x = T0_( i, j, k, 0 );
+        double sum = 0.0;
+        sum += active_( i - 1, j, k ) ? T0_( i - 1, j, k, 0 ) - x : 0.0;
+        sum += active_( i + 1, j, k ) ? T0_( i + 1, j, k, 0 ) - x : 0.0;
+        sum += active_( i, j - 1, k ) ? T0_( i, j - 1, k, 0 ) - x : 0.0;
+        sum += active_( i, j + 1, k ) ? T0_( i, j + 1, k, 0 ) - x : 0.0;
+        sum += active_( i, j, k - 1 ) ? T0_( i, j, k - 1, 0 ) - x : 0.0;
+        sum += active_( i, j, k + 1 ) ? T0_( i, j, k + 1, 0 ) - x : 0.0;
+        return sum * k_by_dx2_;
+    }
+
     // Normalized weight for the gaussian source term: x in exp(-x)
     KOKKOS_INLINE_FUNCTION
     auto weight( const int i, const int j, const int k ) const
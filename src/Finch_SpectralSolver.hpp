@@ -0,0 +1,700 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file SpectralSolver.hpp
+  \brief Exact heat transport solve for linear conduction in cosine space
+*/
+
+#ifndef SpectralSolver_H
+#define SpectralSolver_H
+
+#include <array>
+#include <memory>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+
+namespace Finch
+{
+
+namespace Impl
+{
+// In-place radix-2 FFT of M (a power of two) interleaved complex values,
+// given the twiddle factors exp( -2 pi i j / M ) for j < M / 2
+template <class TwiddleType>
+KOKKOS_INLINE_FUNCTION void fft( double* a, const int M,
+                                 const TwiddleType& twiddle )
+{
+    for ( int i = 1, j = 0; i < M; ++i )
+    {
+        int bit = M >> 1;
+        for ( ; j & bit; bit >>= 1 )
+            j ^= bit;
+        j |= bit;
+        if ( i < j )
+        {
+            for ( int c = 0; c < 2; ++c )
+            {
+                double x = a[2 * i + c];
+                a[2 * i + c] = a[2 * j + c];
+                a[2 * j + c] = x;
+            }
+        }
+    }
+    for ( int length = 2; length <= M; length <<= 1 )
+    {
+        const int half = length / 2;
+        const int stride = M / length;
+        for ( int s = 0; s < M; s += length )
+        {
+            for ( int t = 0; t < half; ++t )
+            {
+                double wr = twiddle( t * stride, 0 );
+                double wi = twiddle( t * stride, 1 );
+                double* u = a + 2 * ( s + t );
+                double* v = a + 2 * ( s + t + half );
+                double vr = v[0] * wr - v[1] * wi;
+                double vi = v[0] * wi + v[1] * wr;
+                v[0] = u[0] - vr;
+                v[1] = u[1] - vi;
+                u[0] += vr;
+                u[1] += vi;
+            }
+        }
+    }
+}
+} // namespace Impl
+
+/*
+  With constant properties and no latent heat, the semi-discrete heat
+  equation (the same 7-point laplacian as the FTCS solver) is linear. With
+  adiabatic boundaries its eigenvectors are the DCT-II modes, so the solution
+  is advanced exactly over any interval by applying exp(-alpha lambda dt) to
+  each mode, with the (frozen) source integrated exactly over the interval.
+
+  The transforms are applied one axis at a time. A pencil transpose (an
+  all-to-all over the ranks along the axis, moving only owned data) gives
+  each rank whole lines along the axis, which are transformed with an
+  O(N log N) cosine transform (Makhoul's reordering of an FFT, using
+  Bluestein's algorithm for any line length), and the reverse transpose
+  returns the owned layout. Spectral data therefore has the same
+  decomposition as the temperature field, and memory and communication scale
+  with the owned extents. Messages are staged through host buffers, so
+  GPU-aware MPI is not required.
+
+  Each step costs six transforms of the field and both transposes per axis,
+  i.e. several FTCS steps: the solver pays off only when steps are combined
+  (beam-off intervals) or for coarse propagation.
+*/
+template <typename ViewType, typename EntityType, typename LocalMeshType>
+class SpectralSolver
+{
+    using memory_space = typename ViewType::memory_space;
+    using view_buffer = Kokkos::View<double****, Kokkos::LayoutRight,
+                                     memory_space>;
+    using view_complex = Kokkos::View<double* [2], memory_space>;
+    using view_scratch =
+        Kokkos::View<double**, Kokkos::LayoutRight, memory_space>;
+    using view_double = Kokkos::View<double*, memory_space>;
+    using view_int = Kokkos::View<int*, memory_space>;
+    using host_double = Kokkos::View<double*, Kokkos::HostSpace>;
+
+  protected:
+    LocalMeshType local_mesh_;
+
+    // solution parameters
+    double dt_;
+    double rho_cp_;
+    double alpha_;
+
+    // heat source parameters
+    double r_[3];
+    double A_inv_[3];
+    double I0_;
+    double w_max_;
+
+    // owned (local) and global node counts, and global offset of this rank
+    std::array<int, 3> n_;
+    std::array<int, 3> N_;
+    std::array<int, 3> offset_;
+
+    // communicators for ranks along each axis, this rank's position and the
+    // global offsets owned by each rank (and the owner of each global index)
+    std::array<std::shared_ptr<MPI_Comm>, 3> line_comm_;
+    std::array<int, 3> line_rank_;
+    std::array<std::vector<int>, 3> line_offsets_;
+    std::array<view_int, 3> line_offsets_view_;
+    std::array<view_int, 3> line_owner_;
+
+    // Bluestein FFT length (a power of two), chirp exp(-i pi n^2 / N), FFT
+    // of the convolution kernel, twiddle factors, DCT phase (cos, sin of
+    // pi k / 2N) and orthonormal weights along each axis
+    std::array<int, 3> M_;
+    std::array<view_complex, 3> chirp_;
+    std::array<view_complex, 3> kernel_;
+    std::array<view_complex, 3> twiddle_;
+    std::array<view_complex, 3> phase_;
+    std::array<view_double, 3> weight_;
+
+    // discrete laplacian eigenvalues for the owned modes along each axis
+    std::array<view_double, 3> lambda_;
+
+    // temperature (component 0) and source (component 1) in owned layout
+    view_buffer buffer_;
+    // owned data ordered by line, whole lines received from (or sent to)
+    // the ranks along an axis, the lines themselves, and FFT scratch
+    view_double owned_;
+    std::array<view_double, 3> pencil_;
+    std::array<view_double, 3> lines_;
+    std::array<view_scratch, 3> scratch_;
+    host_double owned_host_;
+    std::array<host_double, 3> pencil_host_;
+
+  public:
+    SpectralSolver( Inputs db, LocalMeshType local_mesh, MPI_Comm comm,
+                    const std::array<int, 3> owned_extents,
+                    const std::array<int, 3> block_ids,
+                    const std::array<int, 3> num_blocks )
+        : local_mesh_( local_mesh )
+        , n_( owned_extents )
+    {
+        double dx = db.space.cell_size;
+
+        dt_ = db.time.time_step;
+
+        rho_cp_ = db.properties.density * db.properties.specific_heat;
+
+        alpha_ = db.properties.thermal_conductivity / rho_cp_;
+
+        // heat source parameter constants
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            r_[d] = db.source.two_sigma[d] / Kokkos::sqrt( 2.0 );
+            A_inv_[d] = 1.0 / r_[d] / r_[d];
+        }
+
+        I0_ = ( 2.0 * db.source.absorption ) /
+              ( M_PI * Kokkos::sqrt( M_PI ) * r_[0] * r_[1] * r_[2] );
+
+        // cut off for 3 standard deviations from heat source center
+        w_max_ = Kokkos::log( 3 ) + 2 * Kokkos::log( 10 );
+
+        for ( int d = 0; d < 3; ++d )
+        {
+            // Ranks sharing the block ids of the other two axes, ordered
+            // along this axis.
+            int a = ( d == 0 ) ? 1 : 0;
+            int b = ( d == 2 ) ? 1 : 2;
+            int color = block_ids[a] * num_blocks[b] + block_ids[b];
+            line_comm_[d] = std::shared_ptr<MPI_Comm>(
+                new MPI_Comm,
+                []( MPI_Comm* c )
+                {
+                    int finalized;
+                    MPI_Finalized( &finalized );
+                    if ( !finalized )
+                        MPI_Comm_free( c );
+                    delete c;
+                } );
+            MPI_Comm_split( comm, color, block_ids[d], line_comm_[d].get() );
+
+            int line_size;
+            MPI_Comm_size( *line_comm_[d], &line_size );
+            MPI_Comm_rank( *line_comm_[d], &line_rank_[d] );
+            std::vector<int> counts( line_size );
+            MPI_Allgather( &n_[d], 1, MPI_INT, counts.data(), 1, MPI_INT,
+                           *line_comm_[d] );
+
+            line_offsets_[d].assign( line_size + 1, 0 );
+            for ( int q = 0; q < line_size; ++q )
+                line_offsets_[d][q + 1] = line_offsets_[d][q] + counts[q];
+            offset_[d] = line_offsets_[d][line_rank_[d]];
+            N_[d] = line_offsets_[d][line_size];
+
+            createTransforms( d, dx );
+
+            // Lines received by this rank (at most, with the source)
+            long max_lines =
+                ( 2L * n_[a] * n_[b] + line_size - 1 ) / line_size;
+            pencil_[d] = view_double( "spectral_pencil", max_lines * N_[d] );
+            lines_[d] = view_double( "spectral_lines", max_lines * N_[d] );
+            pencil_host_[d] =
+                Kokkos::create_mirror_view( Kokkos::HostSpace(), pencil_[d] );
+
+            // Transform lines in chunks to bound the FFT scratch
+            long chunk = std::max( 1L, std::min( max_lines,
+                                                 ( 1L << 22 ) / M_[d] ) );
+            scratch_[d] =
+                view_scratch( "spectral_scratch", chunk, 2 * M_[d] );
+        }
+
+        buffer_ = view_buffer( "spectral_buffer", n_[0], n_[1], n_[2], 2 );
+        owned_ = view_double( "spectral_owned", buffer_.size() );
+        owned_host_ = Kokkos::create_mirror_view( Kokkos::HostSpace(), owned_ );
+    }
+
+    // Fast orthonormal DCT-II tables for one axis, the owner of each global
+    // index, and the eigenvalues of the second difference operator with
+    // adiabatic (mirrored) ends for the owned modes.
+    void createTransforms( const int d, const double dx )
+    {
+        const int N = N_[d];
+        const int n = n_[d];
+        int M = 1;
+        while ( M < 2 * N - 1 )
+            M *= 2;
+        M_[d] = M;
+
+        chirp_[d] = view_complex( "spectral_chirp", N );
+        kernel_[d] = view_complex( "spectral_kernel", M );
+        twiddle_[d] = view_complex( "spectral_twiddle", std::max( M / 2, 1 ) );
+        phase_[d] = view_complex( "spectral_phase", N );
+        weight_[d] = view_double( "spectral_weight", N );
+        line_owner_[d] = view_int( "spectral_owner", N );
+        line_offsets_view_[d] =
+            view_int( "spectral_offsets", line_offsets_[d].size() );
+        lambda_[d] = view_double( "spectral_eigenvalues", n );
+
+        auto chirp = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                 chirp_[d] );
+        auto twiddle = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                   twiddle_[d] );
+        auto phase = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                 phase_[d] );
+        auto weight = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                  weight_[d] );
+        auto owner = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                 line_owner_[d] );
+        auto offsets = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                   line_offsets_view_[d] );
+        auto lambda = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                  lambda_[d] );
+        std::vector<double> kernel( 2 * M, 0.0 );
+
+        for ( int k = 0; k < N; ++k )
+        {
+            // n^2 mod 2N keeps the chirp phase accurate for long lines
+            double angle =
+                M_PI * static_cast<double>( ( 1L * k * k ) % ( 2L * N ) ) / N;
+            chirp( k, 0 ) = Kokkos::cos( angle );
+            chirp( k, 1 ) = -Kokkos::sin( angle );
+            phase( k, 0 ) = Kokkos::cos( M_PI * k / ( 2.0 * N ) );
+            phase( k, 1 ) = Kokkos::sin( M_PI * k / ( 2.0 * N ) );
+            weight( k ) = ( k == 0 ) ? Kokkos::sqrt( 1.0 / N )
+                                     : Kokkos::sqrt( 2.0 / N );
+        }
+        for ( int j = 0; j < M / 2; ++j )
+        {
+            twiddle( j, 0 ) = Kokkos::cos( 2.0 * M_PI * j / M );
+            twiddle( j, 1 ) = -Kokkos::sin( 2.0 * M_PI * j / M );
+        }
+
+        // Convolution kernel conj(chirp), wrapped for negative offsets
+        for ( int m = 0; m < N; ++m )
+        {
+            kernel[2 * m] = chirp( m, 0 );
+            kernel[2 * m + 1] = -chirp( m, 1 );
+            if ( m > 0 )
+            {
+                kernel[2 * ( M - m )] = chirp( m, 0 );
+                kernel[2 * ( M - m ) + 1] = -chirp( m, 1 );
+            }
+        }
+        Impl::fft( kernel.data(), M, twiddle );
+        auto kernel_host = Kokkos::create_mirror_view( Kokkos::HostSpace(),
+                                                       kernel_[d] );
+        for ( int m = 0; m < M; ++m )
+            for ( int c = 0; c < 2; ++c )
+                kernel_host( m, c ) = kernel[2 * m + c];
+
+        for ( std::size_t q = 0; q + 1 < line_offsets_[d].size(); ++q )
+            for ( int g = line_offsets_[d][q]; g < line_offsets_[d][q + 1];
+                  ++g )
+                owner( g ) = q;
+        for ( std::size_t q = 0; q < line_offsets_[d].size(); ++q )
+            offsets( q ) = line_offsets_[d][q];
+
+        for ( int l = 0; l < n; ++l )
+            lambda( l ) =
+                ( 2.0 - 2.0 * Kokkos::cos( M_PI * ( offset_[d] + l ) / N ) ) /
+                ( dx * dx );
+
+        Kokkos::deep_copy( chirp_[d], chirp );
+        Kokkos::deep_copy( kernel_[d], kernel_host );
+        Kokkos::deep_copy( twiddle_[d], twiddle );
+        Kokkos::deep_copy( phase_[d], phase );
+        Kokkos::deep_copy( weight_[d], weight );
+        Kokkos::deep_copy( line_owner_[d], owner );
+        Kokkos::deep_copy( line_offsets_view_[d], offsets );
+        Kokkos::deep_copy( lambda_[d], lambda );
+    }
+
+    // Function for temperature solve over a single time step
+    template <class ExecSpace, class IndexSpaceType>
+    void solve( ExecSpace exec_space, IndexSpaceType owned_space, ViewType& T,
+                ViewType& T0, const double beam_power,
+                const double beam_pos[3] )
+    {
+        solve( exec_space, owned_space, T, T0, beam_power, beam_pos, dt_ );
+    }
+
+    // Function for temperature solve over an arbitrary interval, with the
+    // source held at the provided beam power and position.
+    template <class ExecSpace, class IndexSpaceType>
+    void solve( ExecSpace exec_space, IndexSpaceType owned_space, ViewType& T,
+                ViewType& T0, const double beam_power,
+                const double beam_pos[3], const double dt )
+    {
+        auto buffer = buffer_;
+        auto local_mesh = local_mesh_;
+        const int nc = ( beam_power > 0.0 ) ? 2 : 1;
+        const double I0_power = I0_ * beam_power;
+        const double w_max = w_max_;
+        const double pos[3] = { beam_pos[0], beam_pos[1], beam_pos[2] };
+        const double A_inv[3] = { A_inv_[0], A_inv_[1], A_inv_[2] };
+        const int min[3] = { static_cast<int>( owned_space.min( 0 ) ),
+                             static_cast<int>( owned_space.min( 1 ) ),
+                             static_cast<int>( owned_space.min( 2 ) ) };
+
+        // Gather the owned temperature and source into the transform buffer
+        Cabana::Grid::grid_parallel_for(
+            "spectral_gather", exec_space, owned_space,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                const int l0 = i - min[0];
+                const int l1 = j - min[1];
+                const int l2 = k - min[2];
+                buffer( l0, l1, l2, 0 ) = T0( i, j, k, 0 );
+                if ( nc > 1 )
+                {
+                    double grid_loc[3];
+                    int idx[3] = { i, j, k };
+                    local_mesh.coordinates( EntityType(), idx, grid_loc );
+                    double w = 0.0;
+                    for ( int d = 0; d < 3; ++d )
+                        w += ( grid_loc[d] - pos[d] ) *
+                             ( grid_loc[d] - pos[d] ) * A_inv[d];
+                    buffer( l0, l1, l2, 1 ) =
+                        ( w < w_max ) ? I0_power * Kokkos::exp( -w ) : 0.0;
+                }
+            } );
+
+        for ( int d = 0; d < 3; ++d )
+            transform( exec_space, d, true, nc );
+
+        // Exact propagation of each mode over the interval
+        auto lambda0 = lambda_[0];
+        auto lambda1 = lambda_[1];
+        auto lambda2 = lambda_[2];
+        const double alpha = alpha_;
+        const double rho_cp = rho_cp_;
+        Kokkos::parallel_for(
+            "spectral_propagate",
+            Kokkos::MDRangePolicy<ExecSpace, Kokkos::Rank<3>>(
+                exec_space, { 0, 0, 0 }, { n_[0], n_[1], n_[2] } ),
+            KOKKOS_LAMBDA( const int l0, const int l1, const int l2 ) {
+                double rate =
+                    alpha * ( lambda0( l0 ) + lambda1( l1 ) + lambda2( l2 ) );
+                double decay = Kokkos::exp( -rate * dt );
+                double T_hat = buffer( l0, l1, l2, 0 ) * decay;
+                if ( nc > 1 )
+                {
+                    double integral =
+                        ( rate > 0.0 ) ? ( 1.0 - decay ) / rate : dt;
+                    T_hat += integral * buffer( l0, l1, l2, 1 ) / rho_cp;
+                }
+                buffer( l0, l1, l2, 0 ) = T_hat;
+            } );
+
+        for ( int d = 0; d < 3; ++d )
+            transform( exec_space, d, false, 1 );
+
+        // Scatter the updated temperature back to the owned nodes
+        Cabana::Grid::grid_parallel_for(
+            "spectral_scatter", exec_space, owned_space,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                T( i, j, k, 0 ) =
+                    buffer( i - min[0], j - min[1], k - min[2], 0 );
+            } );
+    }
+
+    // Apply the forward (DCT-II) or inverse (DCT-III) transform along axis
+    // d to the first nc buffer components, leaving the result in the buffer
+    // in owned layout.
+    template <class ExecSpace>
+    void transform( ExecSpace exec_space, const int d, const bool forward,
+                    const int nc )
+    {
+        auto buffer = buffer_;
+        auto owned = owned_;
+        auto pencil = pencil_[d];
+        auto lines = lines_[d];
+        auto owner = line_owner_[d];
+        auto offsets = line_offsets_view_[d];
+        const int a = ( d == 0 ) ? 1 : 0;
+        const int b = ( d == 2 ) ? 1 : 2;
+        const int N = N_[d];
+        const int n = n_[d];
+        const int na = n_[a];
+        const int nb = n_[b];
+
+        // Lines are (component, a, b) tuples, split evenly over the ranks
+        // along the axis
+        const int P = static_cast<int>( line_offsets_[d].size() ) - 1;
+        const long total = 1L * nc * na * nb;
+        std::vector<long> first( P + 1 );
+        for ( int r = 0; r <= P; ++r )
+            first[r] = total * r / P;
+        const int me = line_rank_[d];
+        const int num_lines = static_cast<int>( first[me + 1] - first[me] );
+
+        std::vector<int> owned_counts( P ), owned_displs( P ),
+            pencil_counts( P ), pencil_displs( P );
+        for ( int r = 0; r < P; ++r )
+        {
+            owned_counts[r] = static_cast<int>( ( first[r + 1] - first[r] ) * n );
+            owned_displs[r] = static_cast<int>( first[r] * n );
+            pencil_counts[r] = num_lines * ( line_offsets_[d][r + 1] -
+                                             line_offsets_[d][r] );
+            pencil_displs[r] = num_lines * line_offsets_[d][r];
+        }
+
+        // Owned data ordered by line (contiguous per destination rank)
+        Kokkos::parallel_for(
+            "spectral_pack",
+            Kokkos::RangePolicy<ExecSpace>( exec_space, 0, total * n ),
+            KOKKOS_LAMBDA( const long p ) {
+                const long t = p / n;
+                int idx[3];
+                idx[d] = p % n;
+                idx[a] = ( t / nb ) % na;
+                idx[b] = t % nb;
+                owned( p ) = buffer( idx[0], idx[1], idx[2], t / ( na * nb ) );
+            } );
+        exchange( exec_space, d, owned_, owned_host_, owned_counts,
+                  owned_displs, pencil_[d], pencil_host_[d], pencil_counts,
+                  pencil_displs );
+
+        // Assemble whole lines from the parts of each rank
+        Kokkos::parallel_for(
+            "spectral_assemble",
+            Kokkos::RangePolicy<ExecSpace>( exec_space, 0, 1L * num_lines * N ),
+            KOKKOS_LAMBDA( const long p ) {
+                const int t = p / N;
+                const int g = p % N;
+                const int q = owner( g );
+                const int start = offsets( q );
+                const int count = offsets( q + 1 ) - start;
+                lines( p ) = pencil( 1L * num_lines * start + 1L * t * count +
+                                     ( g - start ) );
+            } );
+
+        transformLines( exec_space, d, forward, num_lines );
+
+        // Return the parts of each line to their owners
+        Kokkos::parallel_for(
+            "spectral_split",
+            Kokkos::RangePolicy<ExecSpace>( exec_space, 0, 1L * num_lines * N ),
+            KOKKOS_LAMBDA( const long p ) {
+                const int t = p / N;
+                const int g = p % N;
+                const int q = owner( g );
+                const int start = offsets( q );
+                const int count = offsets( q + 1 ) - start;
+                pencil( 1L * num_lines * start + 1L * t * count +
+                        ( g - start ) ) = lines( p );
+            } );
+        exchange( exec_space, d, pencil_[d], pencil_host_[d], pencil_counts,
+                  pencil_displs, owned_, owned_host_, owned_counts,
+                  owned_displs );
+
+        Kokkos::parallel_for(
+            "spectral_unpack",
+            Kokkos::RangePolicy<ExecSpace>( exec_space, 0, total * n ),
+            KOKKOS_LAMBDA( const long p ) {
+                const long t = p / n;
+                int idx[3];
+                idx[d] = p % n;
+                idx[a] = ( t / nb ) % na;
+                idx[b] = t % nb;
+                buffer( idx[0], idx[1], idx[2], t / ( na * nb ) ) = owned( p );
+            } );
+    }
+
+    // All-to-all over the ranks along axis d, staged through host buffers
+    template <class ExecSpace>
+    void exchange( ExecSpace exec_space, const int d, const view_double& send,
+                   const host_double& send_host,
+                   const std::vector<int>& send_counts,
+                   const std::vector<int>& send_displs,
+                   const view_double& recv, const host_double& recv_host,
+                   const std::vector<int>& recv_counts,
+                   const std::vector<int>& recv_displs )
+    {
+        exec_space.fence();
+        Kokkos::deep_copy( send_host, send );
+        MPI_Alltoallv( send_host.data(), send_counts.data(),
+                       send_displs.data(), MPI_DOUBLE, recv_host.data(),
+                       recv_counts.data(), recv_displs.data(), MPI_DOUBLE,
+                       *line_comm_[d] );
+        Kokkos::deep_copy( recv, recv_host );
+    }
+
+    // Orthonormal DCT-II (forward) or its inverse of whole lines, each as a
+    // length N FFT of the even/odd reordered line by Bluestein's algorithm
+    template <class ExecSpace>
+    void transformLines( ExecSpace exec_space, const int d,
+                         const bool forward, const int num_lines )
+    {
+        auto lines = lines_[d];
+        auto scratch = scratch_[d];
+        auto chirp = chirp_[d];
+        auto kernel = kernel_[d];
+        auto twiddle = twiddle_[d];
+        auto phase = phase_[d];
+        auto weight = weight_[d];
+        const int N = N_[d];
+        const int M = M_[d];
+        const int chunk = scratch.extent( 0 );
+
+        for ( int begin = 0; begin < num_lines; begin += chunk )
+        {
+            const int end = std::min( num_lines, begin + chunk );
+            Kokkos::parallel_for(
+                "spectral_dct",
+                Kokkos::RangePolicy<ExecSpace>( exec_space, begin, end ),
+                KOKKOS_LAMBDA( const int t ) {
+                    double* a = &scratch( t - begin, 0 );
+                    const long line = 1L * t * N;
+
+                    // Chirp-modulated input, zero padded
+                    for ( int m = 2 * N; m < 2 * M; ++m )
+                        a[m] = 0.0;
+                    for ( int k = 0; k < N; ++k )
+                    {
+                        double xr, xi;
+                        if ( forward )
+                        {
+                            // v_k: even entries, then odd entries reversed
+                            int i = ( 2 * k < N ) ? 2 * k
+                                                  : 2 * ( N - 1 - k ) + 1;
+                            xr = lines( line + i );
+                            xi = 0.0;
+                        }
+                        else
+                        {
+                            // conj( e^{i pi k/2N} ( C_k - i C_{N-k} ) ),
+                            // with C the unnormalized DCT-II coefficients
+                            double c = lines( line + k ) / weight( k );
+                            double c_rev =
+                                ( k > 0 ) ? lines( line + N - k ) /
+                                                weight( N - k )
+                                          : 0.0;
+                            xr = c * phase( k, 0 ) + c_rev * phase( k, 1 );
+                            xi = c_rev * phase( k, 0 ) - c * phase( k, 1 );
+                        }
+                        a[2 * k] = xr * chirp( k, 0 ) - xi * chirp( k, 1 );
+                        a[2 * k + 1] = xr * chirp( k, 1 ) + xi * chirp( k, 0 );
+                    }
+
+                    // Convolution with the kernel (inverse FFT by conjugation)
+                    Impl::fft( a, M, twiddle );
+                    for ( int m = 0; m < M; ++m )
+                    {
+                        double ar = a[2 * m];
+                        double ai = a[2 * m + 1];
+                        a[2 * m] = ar * kernel( m, 0 ) - ai * kernel( m, 1 );
+                        a[2 * m + 1] =
+                            -( ar * kernel( m, 1 ) + ai * kernel( m, 0 ) );
+                    }
+                    Impl::fft( a, M, twiddle );
+
+                    for ( int k = 0; k < N; ++k )
+                    {
+                        double ar = a[2 * k] / M;
+                        double ai = -a[2 * k + 1] / M;
+                        double yr = ar * chirp( k, 0 ) - ai * chirp( k, 1 );
+                        double yi = ar * chirp( k, 1 ) + ai * chirp( k, 0 );
+                        if ( forward )
+                            lines( line + k ) =
+                                weight( k ) *
+                                ( yr * phase( k, 0 ) + yi * phase( k, 1 ) );
+                        else
+                            a[2 * k] = yr / N;
+                    }
+
+                    // Undo the even/odd reordering
+                    if ( !forward )
+                    {
+                        for ( int k = 0; k < N; ++k )
+                        {
+                            int i = ( 2 * k < N ) ? 2 * k
+                                                  : 2 * ( N - 1 - k ) + 1;
+                            lines( line + i ) = a[2 * k];
+                        }
+                    }
+                } );
+        }
+    }
+};
+
+template <class SolverType>
+struct isSpectralSolver : std::false_type
+{
+};
+
+template <typename ViewType, typename EntityType, typename LocalMeshType>
+struct isSpectralSolver<SpectralSolver<ViewType, EntityType, LocalMeshType>>
+    : std::true_type
+{
+};
+
+// Create a spectral solver based on the grid details and simulation inputs.
+template <typename MemorySpace>
+auto createSpectralSolver( Inputs db, Grid<MemorySpace> grid )
+{
+    using entity_type = typename Grid<MemorySpace>::entity_type;
+    using view_type = typename Grid<MemorySpace>::view_type;
+    using mesh_type = typename Grid<MemorySpace>::local_mesh_type;
+
+    for ( auto& type : grid.getBoundaryTypes() )
+        if ( type != "adiabatic" )
+            throw std::runtime_error(
+                "Error: the spectral solver requires adiabatic boundaries" );
+
+    auto local_mesh = grid.getLocalMesh();
+    auto owned_space = grid.getIndexSpace();
+    auto& global_grid = grid.getLocalGrid()->globalGrid();
+
+    std::array<int, 3> owned_extents, block_ids, num_blocks;
+    for ( int d = 0; d < 3; ++d )
+    {
+        owned_extents[d] = owned_space.extent( d );
+        block_ids[d] = global_grid.dimBlockId( d );
+        num_blocks[d] = global_grid.dimNumBlock( d );
+    }
+
+    return SpectralSolver<view_type, entity_type, mesh_type>(
+        db, local_mesh, grid.getComm(), owned_extents, block_ids,
+        num_blocks );
+}
+
+} // namespace Finch
+
+#endif
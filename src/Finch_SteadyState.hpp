@@ -0,0 +1,533 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file SteadyState.hpp
+  \brief Quasi-steady melt pool of a constant speed track in the beam frame
+*/
+
+#ifndef SteadyState_H
+#define SteadyState_H
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <type_traits>
+#include <vector>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+#include "Finch_Inputs.hpp"
+#include "Finch_SolidificationData.hpp"
+#include "Finch_Solver.hpp"
+#include "MovingBeam/Finch_MovingBeam.hpp"
+
+namespace Finch
+{
+
+template <class SourceTag>
+struct SteadyTag
+{
+};
+
+/*
+  Pseudo-transient iteration towards the steady state in the frame attached
+  to a beam moving with constant velocity v, in terms of the enthalpy H (with
+  latent heat released linearly between the solidus and liquidus):
+
+    dH/dtau = k lap( T ) + q + v . grad( H )
+
+  using the FTCS stencil and source of Solver, with first-order upwind
+  differences for the advection (material moves with -v). Updating the
+  enthalpy rather than using an effective heat capacity avoids cells
+  oscillating across the solidus or liquidus without converging.
+*/
+template <typename ViewType, typename EntityType, typename LocalMeshType>
+class SteadySolver : public Solver<ViewType, EntityType, LocalMeshType>
+{
+    using base_type = Solver<ViewType, EntityType, LocalMeshType>;
+    using memory_space = typename ViewType::memory_space;
+
+  protected:
+    double velocity_[3];
+    double cell_size_;
+
+  public:
+    SteadySolver( Inputs db, LocalMeshType local_mesh,
+                  const double velocity[3], const double pseudo_dt )
+        : base_type( db, local_mesh )
+        , cell_size_( db.space.cell_size )
+    {
+        this->dt_ = pseudo_dt;
+        for ( std::size_t d = 0; d < 3; ++d )
+            velocity_[d] = velocity[d];
+    }
+
+    // One pseudo time step with the beam fixed at beam_pos
+    template <class ExecSpace, class IndexSpaceType>
+    void solve( ExecSpace exec_space, IndexSpaceType owned_space, ViewType& T,
+                ViewType& T0, const double beam_power,
+                const double beam_pos[3] )
+    {
+        this->T_ = T;
+
+        this->T0_ = T0;
+
+        this->power_ = beam_power;
+
+        for ( std::size_t d = 0; d < 3; ++d )
+        {
+            this->position_[d] = beam_pos[d];
+        }
+
+        if constexpr ( std::is_same<memory_space, Kokkos::HostSpace>::value )
+        {
+            Cabana::Grid::grid_parallel_for( "solve_steady", exec_space,
+                                             owned_space, SteadyTag<HostTag>{},
+                                             *this );
+        }
+        else
+        {
+            Cabana::Grid::grid_parallel_for(
+                "solve_steady", exec_space, owned_space,
+                SteadyTag<DeviceTag>{}, *this );
+        }
+    }
+
+    template <class SourceTag>
+    KOKKOS_INLINE_FUNCTION void operator()( SteadyTag<SourceTag>, const int i,
+                                            const int j, const int k ) const
+    {
+        double rhs = this->laplacian( i, j, k ) +
+                     this->source( SourceTag{}, i, j, k ) +
+                     advection( i, j, k );
+
+        double h = enthalpy( this->T0_( i, j, k, 0 ) ) + rhs * this->dt_;
+
+        this->T_( i, j, k, 0 ) = temperature( h );
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    double enthalpy( const double T ) const
+    {
+        double mushy = Kokkos::fmin(
+            Kokkos::fmax( T - this->solidus_, 0.0 ),
+            this->liquidus_ - this->solidus_ );
+        return this->rho_cp_ * T + this->rho_Lf_by_dT_ * mushy;
+    }
+
+    KOKKOS_INLINE_FUNCTION
+    double temperature( const double h ) const
+    {
+        double h_solidus = this->rho_cp_ * this->solidus_;
+        double h_liquidus = enthalpy( this->liquidus_ );
+        if ( h <= h_solidus )
+            return h / this->rho_cp_;
+        else if ( h >= h_liquidus )
+            return this->liquidus_ +
+                   ( h - h_liquidus ) / this->rho_cp_;
+        else
+            return this->solidus_ +
+                   ( h - h_solidus ) / ( this->rho_cp_ + this->rho_Lf_by_dT_ );
+    }
+
+    // Upwind v . grad( H )
+    KOKKOS_INLINE_FUNCTION
+    double advection( const int i, const int j, const int k ) const
+    {
+        double sum = 0.0;
+        int idx[3] = { i, j, k };
+        for ( int d = 0; d < 3; ++d )
+        {
+            if ( velocity_[d] == 0.0 )
+                continue;
+            int up[3] = { i, j, k };
+            up[d] += ( velocity_[d] > 0.0 ) ? 1 : -1;
+            sum += Kokkos::fabs( velocity_[d] ) *
+                   ( enthalpy( this->T0_( up[0], up[1], up[2], 0 ) ) -
+                     enthalpy( this->T0_( idx[0], idx[1], idx[2], 0 ) ) ) /
+                   cell_size_;
+        }
+        return sum;
+    }
+};
+
+/*
+  Steady melt pool of the last track of the scan path: the grid is taken as
+  the domain at the end of the track, with the beam fixed at its end
+  position. Starting from the Rosenthal solution, pseudo time steps are taken
+  until the largest rate of change falls below the tolerance. Solidification
+  events are extracted at the trailing liquidus crossing along the track
+  direction, with times mapped back to the lab frame (a point at distance s
+  behind the crossing solidified s / |v| before the end of the track).
+*/
+template <class MemorySpace>
+class SteadyLayer
+{
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using grid_type = Grid<memory_space>;
+    using entity_type = typename grid_type::entity_type;
+    using view_double2D = Kokkos::View<double**, memory_space>;
+    using view_int = Kokkos::View<int*, memory_space>;
+
+    int comm_rank_;
+    bool sampling_;
+    std::string folder_name_;
+    std::string format_;
+    double liquidus_;
+    double cell_size_;
+    double tolerance_;
+    int max_iterations_;
+
+    // track: end time, beam position at the end, power, and velocity
+    double end_time_;
+    double position_[3];
+    double power_;
+    double velocity_[3];
+    double pseudo_dt_;
+
+    // ghost planes ahead of the beam, where material enters the domain at
+    // the initial temperature
+    double initial_temperature_;
+    std::vector<Cabana::Grid::IndexSpace<3>> inflow_spaces_;
+
+    view_double2D events_;
+    view_int count_;
+
+  public:
+    SteadyLayer( const Inputs& inputs, grid_type& grid, MovingBeam& beam )
+        : comm_rank_( grid.comm_rank )
+        , sampling_( inputs.sampling.enabled )
+        , folder_name_( inputs.sampling.directory_name )
+        , format_( inputs.sampling.format )
+        , liquidus_( inputs.properties.liquidus )
+        , cell_size_( inputs.space.cell_size )
+        , tolerance_( inputs.numerics.steady_tolerance )
+        , max_iterations_( inputs.numerics.steady_max_iterations )
+        , initial_temperature_( inputs.space.initial_temperature )
+    {
+        end_time_ = beam.endTime();
+        beam.move( end_time_ );
+        power_ = beam.power();
+        auto velocity = beam.velocity();
+        double speed = 0.0;
+        for ( int d = 0; d < 3; ++d )
+        {
+            position_[d] = beam.position( d );
+            velocity_[d] = velocity[d];
+            speed += velocity[d] * velocity[d];
+        }
+        if ( power_ <= 0.0 || speed == 0.0 )
+            throw std::runtime_error( "Error: the steady solver requires a "
+                                      "scan path ending in a moving beam" );
+
+        // Explicit stability limit for diffusion and upwind advection
+        double dx = inputs.space.cell_size;
+        double alpha = inputs.properties.thermal_diffusivity;
+        double limit = 6.0 * alpha / ( dx * dx );
+        for ( int d = 0; d < 3; ++d )
+            limit += std::fabs( velocity_[d] ) / dx;
+        pseudo_dt_ = std::min( inputs.time.time_step, 1.0 / limit );
+
+        for ( int d = 0; d < 3; ++d )
+        {
+            if ( velocity_[d] == 0.0 )
+                continue;
+            std::array<int, 3> plane = { 0, 0, 0 };
+            plane[d] = ( velocity_[d] > 0.0 ) ? 1 : -1;
+            inflow_spaces_.push_back(
+                grid.getLocalGrid()->boundaryIndexSpace(
+                    Cabana::Grid::Ghost(), entity_type(), plane[0], plane[1],
+                    plane[2] ) );
+        }
+
+        count_ = view_int( "steady_count", 1 );
+        events_ = view_double2D( "steady_events", grid.getIndexSpace().size(),
+                                 9 );
+    }
+
+    // Rosenthal solution for a moving point source on a semi-infinite body,
+    // smoothed over the beam radius
+    void initialize( const Inputs& inputs, grid_type& grid )
+    {
+        double speed = std::sqrt( velocity_[0] * velocity_[0] +
+                                  velocity_[1] * velocity_[1] +
+                                  velocity_[2] * velocity_[2] );
+        double alpha = inputs.properties.thermal_diffusivity;
+        double amplitude = inputs.source.absorption * power_ /
+                           ( 2.0 * M_PI * inputs.properties.thermal_conductivity );
+        double r2 = 0.5 * ( inputs.source.two_sigma[0] *
+                                inputs.source.two_sigma[0] +
+                            inputs.source.two_sigma[1] *
+                                inputs.source.two_sigma[1] ) /
+                    2.0;
+        double T_init = inputs.space.initial_temperature;
+        Kokkos::Array<double, 3> p, n;
+        for ( int d = 0; d < 3; ++d )
+        {
+            p[d] = position_[d];
+            n[d] = velocity_[d] / speed;
+        }
+
+        auto T = grid.getTemperature();
+        auto local_mesh = grid.getLocalMesh();
+        Cabana::Grid::grid_parallel_for(
+            "steady_initialize", exec_space(), grid.getIndexSpace(),
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                double pt[3];
+                int idx[3] = { i, j, k };
+                local_mesh.coordinates( entity_type(), idx, pt );
+                double dist2 = r2;
+                double ahead = 0.0;
+                for ( int d = 0; d < 3; ++d )
+                {
+                    dist2 += ( pt[d] - p[d] ) * ( pt[d] - p[d] );
+                    ahead += ( pt[d] - p[d] ) * n[d];
+                }
+                double R = Kokkos::sqrt( dist2 );
+                T( i, j, k, 0 ) =
+                    T_init + amplitude / R *
+                                 Kokkos::exp( -speed * ( R + ahead ) /
+                                              ( 2.0 * alpha ) );
+            } );
+        updateBoundaries( grid );
+        grid.gather();
+    }
+
+    // Boundary conditions, with the inflow planes at the initial temperature
+    void updateBoundaries( grid_type& grid )
+    {
+        grid.updateBoundaries();
+
+        auto T = grid.getTemperature();
+        double T_init = initial_temperature_;
+        for ( auto& space : inflow_spaces_ )
+            Cabana::Grid::grid_parallel_for(
+                "steady_inflow", exec_space(), space,
+                KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                    T( i, j, k, 0 ) = T_init;
+                } );
+    }
+
+    void run( exec_space exec, const Inputs& inputs, grid_type& grid )
+    {
+        initialize( inputs, grid );
+
+        using view_type = typename grid_type::view_type;
+        using mesh_type = typename grid_type::local_mesh_type;
+        SteadySolver<view_type, entity_type, mesh_type> fd(
+            inputs, grid.getLocalMesh(), velocity_, pseudo_dt_ );
+
+        auto owned_space = grid.getIndexSpace();
+        const int check_interval = 100;
+        double rate = std::numeric_limits<double>::max();
+        int n = 0;
+        while ( n < max_iterations_ && rate > tolerance_ )
+        {
+            grid.swapTemperature();
+            auto T = grid.getTemperature();
+            auto T0 = grid.getPreviousTemperature();
+            fd.solve( exec, owned_space, T, T0, power_, position_ );
+            updateBoundaries( grid );
+            grid.gather();
+            ++n;
+
+            if ( n % check_interval == 0 || n == max_iterations_ )
+            {
+                rate = maxChange( grid ) / pseudo_dt_;
+                if ( comm_rank_ == 0 )
+                    std::cout << "Steady iteration " << n
+                              << ": max rate of change " << std::scientific
+                              << std::setprecision( 3 ) << rate << " K/s"
+                              << std::endl;
+            }
+        }
+        if ( rate > tolerance_ && comm_rank_ == 0 )
+            std::cout << "Warning: steady solver did not converge"
+                      << std::endl;
+
+        if ( inputs.time.output.total_steps > 0 )
+            grid.output( n, end_time_ );
+
+        if ( sampling_ )
+            extractEvents( grid );
+    }
+
+    // Largest temperature change over the owned cells in the last iteration
+    double maxChange( grid_type& grid )
+    {
+        auto T = grid.getTemperature();
+        auto T0 = grid.getPreviousTemperature();
+        double local_max = 0.0;
+        Kokkos::Max<double> reducer( local_max );
+        Cabana::Grid::grid_parallel_reduce(
+            "steady_change", exec_space(), grid.getIndexSpace(),
+            KOKKOS_LAMBDA( const int i, const int j, const int k,
+                           double& max ) {
+                double change =
+                    Kokkos::fabs( T( i, j, k, 0 ) - T0( i, j, k, 0 ) );
+                if ( change > max )
+                    max = change;
+            },
+            reducer );
+
+        double global_max;
+        MPI_Allreduce( &local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX,
+                       grid.getComm() );
+        return global_max;
+    }
+
+    void extractEvents( grid_type& grid )
+    {
+        // Track direction (largest velocity component) and the other axes
+        int a = 0;
+        for ( int d = 1; d < 3; ++d )
+            if ( std::fabs( velocity_[d] ) > std::fabs( velocity_[a] ) )
+                a = d;
+        int b = ( a + 1 ) % 3;
+        int c = ( a + 2 ) % 3;
+        int s = ( velocity_[a] > 0.0 ) ? 1 : -1;
+        double speed_a = std::fabs( velocity_[a] );
+
+        auto local_grid = grid.getLocalGrid();
+        const auto& global_grid = local_grid->globalGrid();
+        auto global_space = local_grid->indexSpace(
+            Cabana::Grid::Own(), entity_type(), Cabana::Grid::Global() );
+        auto owned_space = grid.getIndexSpace();
+        Kokkos::Array<int, 3> offset;
+        for ( int d = 0; d < 3; ++d )
+            offset[d] = global_space.min( d ) - owned_space.min( d );
+        int num_b = global_grid.globalNumEntity( entity_type(), b );
+        int num_c = global_grid.globalNumEntity( entity_type(), c );
+
+        auto T = grid.getTemperature();
+        auto local_mesh = grid.getLocalMesh();
+        double liquidus = liquidus_;
+        double cell_size = cell_size_;
+        Kokkos::Array<int, 3> ahead = { 0, 0, 0 };
+        ahead[a] = s;
+
+        // Leading edge of the melt pool on each line along the track, as the
+        // largest coordinate in the direction of travel
+        Kokkos::View<double**, memory_space> front( "steady_front", num_b,
+                                                    num_c );
+        Kokkos::deep_copy( front, -std::numeric_limits<double>::max() );
+        Cabana::Grid::grid_parallel_for(
+            "steady_front", exec_space(), owned_space,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                double temp = T( i, j, k, 0 );
+                double temp_ahead =
+                    T( i + ahead[0], j + ahead[1], k + ahead[2], 0 );
+                if ( temp > liquidus && temp_ahead <= liquidus )
+                {
+                    int idx[3] = { i, j, k };
+                    double pt[3];
+                    local_mesh.coordinates( entity_type(), idx, pt );
+                    double m = ( temp - liquidus ) / ( temp - temp_ahead );
+                    Kokkos::atomic_max(
+                        &front( idx[b] + offset[b], idx[c] + offset[c] ),
+                        s * pt[a] + m * cell_size );
+                }
+            } );
+        auto front_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), front );
+        MPI_Allreduce( MPI_IN_PLACE, front_host.data(), num_b * num_c,
+                       MPI_DOUBLE, MPI_MAX, grid.getComm() );
+        Kokkos::deep_copy( front, front_host );
+
+        // Trailing edge: material arrives from the cell ahead
+        Kokkos::deep_copy( count_, 0 );
+        auto events = events_;
+        auto count = count_;
+        double end_time = end_time_;
+        Kokkos::Array<double, 3> velocity;
+        for ( int d = 0; d < 3; ++d )
+            velocity[d] = velocity_[d];
+        Cabana::Grid::grid_parallel_for(
+            "steady_events", exec_space(), owned_space,
+            KOKKOS_LAMBDA( const int i, const int j, const int k ) {
+                double temp = T( i, j, k, 0 );
+                double temp_up =
+                    T( i + ahead[0], j + ahead[1], k + ahead[2], 0 );
+                if ( temp > liquidus || temp_up <= liquidus )
+                    return;
+
+                int idx[3] = { i, j, k };
+                double pt[3];
+                local_mesh.coordinates( entity_type(), idx, pt );
+                double leading =
+                    front( idx[b] + offset[b], idx[c] + offset[c] );
+                if ( leading < s * pt[a] )
+                    return;
+
+                int n = Kokkos::atomic_fetch_add( &count( 0 ), 1 );
+                for ( int d = 0; d < 3; ++d )
+                    events( n, d ) = pt[d];
+
+                // melting and solidification times
+                double m = ( liquidus - temp ) / ( temp_up - temp );
+                events( n, 3 ) = end_time - ( leading - s * pt[a] ) / speed_a;
+                events( n, 4 ) = end_time - m * cell_size / speed_a;
+
+                // temperature gradient and cooling rate ( -DT/Dt = v . G )
+                double rate = 0.0;
+                for ( int d = 0; d < 3; ++d )
+                {
+                    int hi[3] = { i, j, k };
+                    int lo[3] = { i, j, k };
+                    hi[d] += 1;
+                    lo[d] -= 1;
+                    double g = ( T( hi[0], hi[1], hi[2], 0 ) -
+                                 T( lo[0], lo[1], lo[2], 0 ) ) /
+                               ( 2.0 * cell_size );
+                    events( n, 6 + d ) = g;
+                    rate += velocity[d] * g;
+                }
+                events( n, 5 ) = rate;
+            } );
+    }
+
+    // Write the solidification data to separate files for each MPI rank
+    // (steady_<rank>.csv, keeping any transient data in the same directory),
+    // in the same format as the transient solvers.
+    void writeSolidificationData()
+    {
+        if ( !sampling_ )
+            return;
+
+        auto events_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), events_ );
+        auto count_host =
+            Kokkos::create_mirror_view_and_copy( Kokkos::HostSpace(), count_ );
+
+        if ( mkdir( folder_name_.c_str(), 0777 ) != -1 )
+            std::cout << "Creating directory: " << folder_name_ << std::endl;
+
+        std::ofstream fout( folder_name_ + "/steady_" +
+                            std::to_string( comm_rank_ ) + ".csv" );
+        fout << std::fixed << std::setprecision( 10 );
+        writeEvents( fout, events_host, count_host( 0 ), format_, 1 );
+    }
+};
+
+} // namespace Finch
+
+#endif
@@ -0,0 +1,154 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file TemperatureExporter.hpp
+  \brief Zero-copy export of the owned temperature field for coupled codes
+*/
+
+#ifndef TemperatureExporter_H
+#define TemperatureExporter_H
+
+#include <array>
+#include <cstddef>
+
+#include <Cabana_Grid.hpp>
+#include <Kokkos_Core.hpp>
+
+#include "Finch_Grid.hpp"
+
+namespace Finch
+{
+
+// Owned temperatures of one time step, aliasing the grid storage (no copy).
+template <class MemorySpace>
+struct TemperatureSnapshot
+{
+    using memory_space = MemorySpace;
+    using view_type =
+        Kokkos::View<const double****, Kokkos::LayoutStride, memory_space,
+                     Kokkos::MemoryUnmanaged>;
+
+    // Owned temperatures indexed as (i, j, k, member)
+    view_type temperature;
+
+    // Global index of the first owned node in each dimension
+    std::array<int, 3> global_offset = { 0, 0, 0 };
+
+    // Node spacing and position of the first owned node
+    std::array<double, 3> cell_size = { 0.0, 0.0, 0.0 };
+    std::array<double, 3> origin = { 0.0, 0.0, 0.0 };
+
+    int step = -1;
+    double time = 0.0;
+
+    bool valid() const { return step >= 0; }
+
+    // Raw (device) pointer and strides, in elements, for non-Kokkos consumers
+    const double* data() const { return temperature.data(); }
+    std::size_t extent( const int d ) const { return temperature.extent( d ); }
+    std::size_t stride( const int d ) const { return temperature.stride( d ); }
+};
+
+/*
+  Publishes the owned temperature field after each step. The grid exchanges
+  its current and previous temperature buffers every step rather than copying,
+  so the snapshot of step n stays unchanged while step n + 1 is computed (it is
+  only read, as the previous temperature) and is overwritten during step
+  n + 2. Consumers must therefore finish with latest() before the next step
+  completes, or copy() it into their own storage.
+*/
+template <class MemorySpace>
+class TemperatureExporter
+{
+  public:
+    using memory_space = MemorySpace;
+    using exec_space = typename memory_space::execution_space;
+    using grid_type = Grid<memory_space>;
+    using snapshot_type = TemperatureSnapshot<memory_space>;
+
+    TemperatureExporter( grid_type& grid )
+        : latest_( 0 )
+    {
+        auto local_grid = grid.getLocalGrid();
+        auto global_space = local_grid->indexSpace(
+            Cabana::Grid::Own(), Cabana::Grid::Node(), Cabana::Grid::Global() );
+        const auto& global_mesh = local_grid->globalGrid().globalMesh();
+        for ( int d = 0; d < 3; ++d )
+        {
+            global_offset_[d] = global_space.min( d );
+            cell_size_[d] = global_mesh.cellSize( d );
+            origin_[d] = global_mesh.lowCorner( d ) +
+                         global_offset_[d] * global_mesh.cellSize( d );
+        }
+    }
+
+    // Publish the current temperature (call after each completed step).
+    const snapshot_type& publish( grid_type& grid, const int step,
+                                  const double time )
+    {
+        // Results must be complete before consumers read them
+        exec_space().fence();
+
+        auto owned_space = grid.getIndexSpace();
+        auto T = grid.getTemperature();
+
+        latest_ = ( latest_ + 1 ) % 2;
+        auto& snapshot = snapshots_[latest_];
+        snapshot.temperature = Kokkos::subview(
+            T, Kokkos::make_pair( owned_space.min( 0 ), owned_space.max( 0 ) ),
+            Kokkos::make_pair( owned_space.min( 1 ), owned_space.max( 1 ) ),
+            Kokkos::make_pair( owned_space.min( 2 ), owned_space.max( 2 ) ),
+            Kokkos::ALL );
+        snapshot.global_offset = global_offset_;
+        snapshot.cell_size = cell_size_;
+        snapshot.origin = origin_;
+        snapshot.step = step;
+        snapshot.time = time;
+        return snapshot;
+    }
+
+    // Publish every step when passed as an observer to Layer::run.
+    template <class Context>
+    void observe( const Context& ctx )
+    {
+        publish( ctx.grid, ctx.step, ctx.time );
+    }
+
+    // Most recently published step.
+    const snapshot_type& latest() const { return snapshots_[latest_]; }
+
+    // Step published before latest(): only valid until the next step starts.
+    const snapshot_type& previous() const
+    {
+        return snapshots_[( latest_ + 1 ) % 2];
+    }
+
+    // Copy the latest snapshot into a consumer view (any layout in the same
+    // memory space) with extents (owned nodes x, y, z, members).
+    template <class ViewType>
+    void copy( const ViewType& destination ) const
+    {
+        Kokkos::deep_copy( destination, latest().temperature );
+    }
+
+  private:
+    std::array<snapshot_type, 2> snapshots_;
+    int latest_;
+
+    std::array<int, 3> global_offset_;
+    std::array<double, 3> cell_size_;
+    std::array<double, 3> origin_;
+};
+
+} // namespace Finch
+
+#endif
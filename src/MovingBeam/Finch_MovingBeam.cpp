@@ -13,6 +13,7 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 #include "Finch_MovingBeam.hpp"
@@ -140,6 +141,37 @@ void MovingBeam::move( const double time )
     }
 }
 
+std::vector<double> MovingBeam::velocity()
+{
+    std::vector<double> velocity( 3, 0.0 );
+
+    const int i = index_;
+    if ( i > 0 && path[i].mode() == 0 )
+    {
+        double dt = path[i].time() - path[i - 1].time();
+        if ( dt > 0 )
+        {
+            for ( int d = 0; d < 3; ++d )
+                velocity[d] =
+                    ( path[i].position()[d] - path[i - 1].position()[d] ) / dt;
+        }
+    }
+
+    return velocity;
+}
+
+double MovingBeam::nextPowerOnTime( const double time )
+{
+    // power for segment i is on over ( path[i - 1].time(), path[i].time() ]
+    for ( std::size_t i = 1; i < path.size(); i++ )
+    {
+        if ( path[i].power() > eps && ( path[i].time() - time ) > eps )
+            return std::max( time, path[i - 1].time() );
+    }
+
+    return std::numeric_limits<double>::max();
+}
+
 int MovingBeam::findIndex( const double time )
 {
     const int n = path.size() - 1;
@@ -71,7 +71,11 @@ class MovingBeam
     int index() const { return index_; }
 
     //! Return end time of path
-    int endTime() const { return endTime_; }
+    double endTime() const { return endTime_; }
+
+    //! Returns the first time, no earlier than the provided time, after
+    //! which the beam power is on (or the largest double if it stays off)
+    double nextPowerOnTime( const double time );
 
     //! Return current position of the moving beam
     std::vector<double> position() const { return position_; }
@@ -81,6 +85,9 @@ class MovingBeam
 
     //! Return current power of the moving beam
     double power() const { return power_; }
+
+    //! Return the velocity of the current segment (zero for point sources)
+    std::vector<double> velocity();
 };
 
 } // namespace Finch
@@ -19,11 +19,13 @@
 #include <unistd.h>
 #include <vector>
 
+#include <Kokkos_Core.hpp>
 #include <nlohmann/json.hpp>
 
 #include "Finch_CreateScanPaths.hpp"
+#include "Finch_Slicer.hpp"
 
-int main( int argc, char* argv[] )
+void run( int argc, char* argv[] )
 {
     // Read input file
     const char* filename = nullptr;
@@ -39,7 +41,7 @@ int main( int argc, char* argv[] )
         {
             std::cerr << "Usage: " << argv[0] << " -i <input_json_file>"
                       << std::endl;
-            return 0;
+            return;
         }
     }
 
@@ -47,17 +49,8 @@ int main( int argc, char* argv[] )
     std::ifstream config_stream( filename );
     nlohmann::json config = nlohmann::json::parse( config_stream );
 
-    Finch::Point minPoint;
-    minPoint.x = config["min_point"][0];
-    minPoint.y = config["min_point"][1];
-
-    Finch::Point maxPoint;
-    maxPoint.x = config["max_point"][0];
-    maxPoint.y = config["max_point"][1];
-
     double angle = config["angle"];
     double hatch = config["hatch"];
-    int num_rotations = config["num_rotations"];
 
     double power = config["power"];
     double speed = config["speed"];
@@ -69,6 +62,51 @@ int main( int argc, char* argv[] )
         bi_direction = config["bi_direction"];
     }
 
+    // Slice a part into layers, rotating the scan angle every layer
+    if ( config.contains( "stl_file" ) )
+    {
+        double scale = config.value( "scale", 1.0 );
+        double layer_thickness = config["layer_thickness"];
+
+        Finch::Slicer slicer( config["stl_file"], scale );
+
+        // Slice through the middle of each layer
+        int num_layers = static_cast<int>( std::round(
+            ( slicer.maxZ() - slicer.minZ() ) / layer_thickness ) );
+        std::vector<double> heights( num_layers );
+        for ( int n = 0; n < num_layers; ++n )
+            heights[n] = slicer.minZ() + ( n + 0.5 ) * layer_thickness;
+
+        auto layers = slicer.slice( heights );
+
+        for ( int n = 0; n < num_layers; ++n )
+        {
+            double rotation = std::fmod( n * angle, 360.0 );
+
+            Finch::Path path( layers[n], hatch, rotation );
+            path.power = power;
+            path.speed = speed;
+            path.dwell_time = dwell_time;
+
+            std::string filename = "path_layer_" + std::to_string( n ) + ".txt";
+            path.write( filename, bi_direction );
+        }
+
+        std::cout << "Sliced " << slicer.numTriangles() << " triangles into "
+                  << num_layers << " layers" << std::endl;
+        return;
+    }
+
+    Finch::Point minPoint;
+    minPoint.x = config["min_point"][0];
+    minPoint.y = config["min_point"][1];
+
+    Finch::Point maxPoint;
+    maxPoint.x = config["max_point"][0];
+    maxPoint.y = config["max_point"][1];
+
+    int num_rotations = config["num_rotations"];
+
     // Create bounding box for scan vectors
     Finch::boundBox boundingBox( minPoint, maxPoint );
 
@@ -93,6 +131,15 @@ int main( int argc, char* argv[] )
 
         rotation += angle;
     }
+}
+
+int main( int argc, char* argv[] )
+{
+    Kokkos::initialize( argc, argv );
+
+    run( argc, argv );
+
+    Kokkos::finalize();
 
     return 0;
 }
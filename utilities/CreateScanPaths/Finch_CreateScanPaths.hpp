@@ -14,6 +14,9 @@
   \brief Define the scan path strategy for additive manufacturing
 */
 
+#ifndef CreateScanPaths_H
+#define CreateScanPaths_H
+
 #include <algorithm>
 #include <cmath>
 #include <fstream>
@@ -117,6 +120,9 @@ struct Line
     }
 };
 
+// Closed polygon (the last point connects back to the first)
+using Polygon = std::vector<Point>;
+
 struct boundBox
 {
     Point minPoint;
@@ -236,6 +242,41 @@ struct Path
 
     // Construct the path from a bounding box and hatch spacing
     Path( boundBox bbox, double step, double angle )
+    {
+        // apply cropping to the rotated lines
+        for ( const Line& rotatedLine : hatchLines( bbox, step, angle ) )
+        {
+            Line croppedLine = bbox.cropLine( rotatedLine );
+
+            if ( croppedLine.isFinite() )
+            {
+                lines.push_back( croppedLine );
+            }
+        }
+    }
+
+    // Construct the path from closed polygons (the regions inside an odd
+    // number of polygons are filled) and hatch spacing
+    Path( const std::vector<Polygon>& polygons, double step, double angle )
+    {
+        if ( polygons.empty() )
+            return;
+
+        boundBox bbox = boundingBox( polygons );
+        for ( const Line& rotatedLine :
+              hatchLines( bbox, step, angle, true ) )
+        {
+            std::vector<Line> croppedLines = cropLine( polygons, rotatedLine );
+            lines.insert( lines.end(), croppedLines.begin(),
+                          croppedLines.end() );
+        }
+    }
+
+    // Function to create the rotated, equally spaced parallel lines covering
+    // the bounding box: infinitely long, or (if bounded) only as long as the
+    // box diagonal so that crossings can be found to round-off in the box size
+    std::vector<Line> hatchLines( const boundBox& bbox, double step,
+                                  double angle, bool bounded = false ) const
     {
         int numLines = numberOfLines( bbox, step );
 
@@ -243,12 +284,20 @@ struct Path
         std::vector<Line> pathLines;
 
         const float great = 1e10;
+        double left = -great;
+        double right = great;
+        if ( bounded )
+        {
+            double length = distance( bbox.minPoint, bbox.maxPoint ) + step;
+            left = bbox.midPoint.x - length;
+            right = bbox.midPoint.x + length;
+        }
 
         // Create lines in the negative direction, excluding the midpoint line
         for ( int i = numLines - 1; i > 0; --i )
         {
             double height = bbox.midPoint.y - i * step;
-            Line currentLine( Point( -great, height ), Point( great, height ) );
+            Line currentLine( Point( left, height ), Point( right, height ) );
             pathLines.push_back( currentLine );
         }
 
@@ -256,24 +305,89 @@ struct Path
         for ( int i = 0; i < numLines; ++i )
         {
             double height = bbox.midPoint.y + i * step;
-            Line currentLine( Point( -great, height ), Point( great, height ) );
+            Line currentLine( Point( left, height ), Point( right, height ) );
             pathLines.push_back( currentLine );
         }
 
-        // apply rotation and cropping to the initial lines
-        for ( const Line& pathLine : pathLines )
+        // Rotate the endpoints by the specified angle
+        for ( Line& pathLine : pathLines )
         {
-            // Rotate the endpoints by the specified angle
-            Line rotatedLine = pathLine;
-            rotatedLine.rotate( bbox.midPoint, angle );
+            pathLine.rotate( bbox.midPoint, angle );
+        }
 
-            Line croppedLine = bbox.cropLine( rotatedLine );
+        return pathLines;
+    }
 
-            if ( croppedLine.isFinite() )
+    // Function to find the bounding box of a set of polygons
+    boundBox boundingBox( const std::vector<Polygon>& polygons ) const
+    {
+        double inf = std::numeric_limits<double>::infinity();
+        Point minP( inf, inf );
+        Point maxP( -inf, -inf );
+        for ( const Polygon& polygon : polygons )
+        {
+            for ( const Point& p : polygon )
             {
-                lines.push_back( croppedLine );
+                minP.x = std::min( minP.x, p.x );
+                minP.y = std::min( minP.y, p.y );
+                maxP.x = std::max( maxP.x, p.x );
+                maxP.y = std::max( maxP.y, p.y );
             }
         }
+        return boundBox( minP, maxP );
+    }
+
+    // Function to crop a line to the inside of the polygons: the crossings
+    // of the polygon edges, sorted along the line, alternately enter and
+    // leave the filled region
+    std::vector<Line> cropLine( const std::vector<Polygon>& polygons,
+                                const Line& line ) const
+    {
+        std::vector<Point> intersections;
+
+        double dx = line.end.x - line.start.x;
+        double dy = line.end.y - line.start.y;
+
+        for ( const Polygon& polygon : polygons )
+        {
+            for ( std::size_t i = 0; i < polygon.size(); ++i )
+            {
+                const Point& a = polygon[i];
+                const Point& b = polygon[( i + 1 ) % polygon.size()];
+
+                // Side of the line for each end of the edge: the end point
+                // is excluded so that a shared vertex is only counted once
+                double sideA = dx * ( a.y - line.start.y ) -
+                               dy * ( a.x - line.start.x );
+                double sideB = dx * ( b.y - line.start.y ) -
+                               dy * ( b.x - line.start.x );
+                if ( ( sideA < 0.0 ) == ( sideB < 0.0 ) )
+                    continue;
+
+                // Interpolate along the (short) polygon edge for accuracy
+                double u = sideA / ( sideA - sideB );
+                intersections.push_back(
+                    Point( a.x + u * ( b.x - a.x ), a.y + u * ( b.y - a.y ) ) );
+            }
+        }
+
+        // Sort intersection points based on position along the line
+        std::sort( intersections.begin(), intersections.end(),
+                   [&line]( const Point& p1, const Point& p2 )
+                   {
+                       double d1 = distance( line.start, p1 );
+                       double d2 = distance( line.start, p2 );
+                       return d1 < d2;
+                   } );
+
+        std::vector<Line> croppedLines;
+        for ( std::size_t i = 0; i + 1 < intersections.size(); i += 2 )
+        {
+            croppedLines.push_back(
+                Line( intersections[i], intersections[i + 1] ) );
+        }
+
+        return croppedLines;
     }
 
     // Function to find the number of scan vectors in the bounding box
@@ -338,3 +452,5 @@ struct Path
 };
 
 } // namespace Finch
+
+#endif
@@ -0,0 +1,305 @@
+/****************************************************************************
+ * Copyright (c) 2024 by Oak Ridge National Laboratory                      *
+ * All rights reserved.                                                     *
+ *                                                                          *
+ * This file is part of Finch. Finch is distributed under a                 *
+ * BSD 3-clause license. For the licensing terms see the LICENSE file in    *
+ * the top-level directory.                                                 *
+ *                                                                          *
+ * SPDX-License-Identifier: BSD-3-Clause                                    *
+ ****************************************************************************/
+
+/*!
+  \file Slicer.hpp
+  \brief Slice a triangulated (STL) part into closed polygons for each layer
+*/
+
+#ifndef Slicer_H
+#define Slicer_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Kokkos_Core.hpp>
+
+#include "Finch_CreateScanPaths.hpp"
+
+namespace Finch
+{
+
+/*
+  Closed triangulated surface, read from a binary or ASCII STL file. Shared
+  vertices are merged and each edge stores the two triangles it joins, so
+  that a cross-section is traced by walking from a triangle crossing the
+  slice height to its neighbour across the other crossing edge until the
+  polygon closes. Vertices exactly at the slice height are treated as above
+  it, so every crossing triangle has exactly two crossing edges.
+*/
+class Slicer
+{
+  public:
+    using Vertex = std::array<double, 3>;
+    using Facet = std::array<Vertex, 3>;
+
+    // Read the surface, scaling all coordinates (e.g. 1e-3 for mm)
+    Slicer( const std::string& filename, const double scale = 1.0 )
+    {
+        std::vector<Facet> facets = read( filename );
+        for ( Facet& facet : facets )
+            for ( Vertex& v : facet )
+                for ( double& x : v )
+                    x *= scale;
+
+        build( facets );
+    }
+
+    // Construct from the triangles directly
+    Slicer( const std::vector<Facet>& facets ) { build( facets ); }
+
+    double minZ() const { return min_z_; }
+    double maxZ() const { return max_z_; }
+
+    int numTriangles() const { return static_cast<int>( triangles_.size() ); }
+
+    // Closed polygons of the cross-section at height z
+    std::vector<Polygon> slice( const double z ) const
+    {
+        std::vector<Polygon> polygons;
+        std::vector<char> visited( triangles_.size(), 0 );
+
+        // Only triangles starting below z can cross it
+        auto end = std::lower_bound(
+            order_.begin(), order_.end(), z, [&]( const int t, double height )
+            { return triangle_min_z_[t] < height; } );
+
+        for ( auto it = order_.begin(); it != end; ++it )
+        {
+            int start = *it;
+            if ( visited[start] || triangle_max_z_[start] < z )
+                continue;
+
+            // Enter through one crossing edge and leave through the other,
+            // into the neighbouring triangle, until back at the start
+            Polygon polygon;
+            int triangle = start;
+            int edge = crossingEdge( triangle, -1, z );
+            do
+            {
+                visited[triangle] = 1;
+                edge = crossingEdge( triangle, edge, z );
+                polygon.push_back( crossingPoint( edge, z ) );
+
+                const auto& neighbours = edge_triangles_[edge];
+                triangle = ( neighbours[0] == triangle ) ? neighbours[1]
+                                                         : neighbours[0];
+            } while ( triangle != start );
+
+            if ( polygon.size() > 2 )
+                polygons.push_back( polygon );
+        }
+
+        return polygons;
+    }
+
+    // Slice all layers at once, in parallel on the host
+    std::vector<std::vector<Polygon>>
+    slice( const std::vector<double>& heights ) const
+    {
+        std::vector<std::vector<Polygon>> layers( heights.size() );
+        Kokkos::parallel_for(
+            "slice_layers",
+            Kokkos::RangePolicy<Kokkos::DefaultHostExecutionSpace>(
+                0, heights.size() ),
+            [&]( const int n ) { layers[n] = slice( heights[n] ); } );
+        return layers;
+    }
+
+  protected:
+    // Read the facets of a binary STL file (if the size matches the
+    // triangle count in its header) or an ASCII STL file
+    std::vector<Facet> read( const std::string& filename ) const
+    {
+        std::ifstream file( filename, std::ios::binary );
+        if ( !file )
+            throw std::runtime_error( "Error: cannot open STL file " +
+                                      filename );
+        std::string data( ( std::istreambuf_iterator<char>( file ) ),
+                          std::istreambuf_iterator<char>() );
+
+        std::vector<Facet> facets;
+        if ( data.size() >= 84 )
+        {
+            std::uint32_t count;
+            std::memcpy( &count, data.data() + 80, sizeof( count ) );
+            if ( data.size() == 84 + 50 * static_cast<std::size_t>( count ) )
+            {
+                // 12 floats (normal and vertices) and 2 attribute bytes each
+                facets.resize( count );
+                for ( std::size_t t = 0; t < count; ++t )
+                {
+                    const char* record = data.data() + 84 + 50 * t + 12;
+                    for ( int v = 0; v < 3; ++v )
+                    {
+                        float x[3];
+                        std::memcpy( x, record + 12 * v, sizeof( x ) );
+                        facets[t][v] = { x[0], x[1], x[2] };
+                    }
+                }
+                return facets;
+            }
+        }
+
+        std::istringstream stream( data );
+        std::string token;
+        Facet facet;
+        int v = 0;
+        while ( stream >> token )
+        {
+            if ( token != "vertex" )
+                continue;
+            stream >> facet[v][0] >> facet[v][1] >> facet[v][2];
+            if ( ++v == 3 )
+            {
+                facets.push_back( facet );
+                v = 0;
+            }
+        }
+        if ( facets.empty() )
+            throw std::runtime_error( "Error: no triangles in STL file " +
+                                      filename );
+        return facets;
+    }
+
+    // Merge shared vertices and index the edge-triangle connectivity
+    void build( const std::vector<Facet>& facets )
+    {
+        std::map<Vertex, int> vertex_index;
+        std::map<std::pair<int, int>, int> edge_index;
+
+        for ( const Facet& facet : facets )
+        {
+            std::array<int, 3> triangle;
+            for ( int v = 0; v < 3; ++v )
+            {
+                auto inserted = vertex_index.emplace(
+                    facet[v], static_cast<int>( vertices_.size() ) );
+                if ( inserted.second )
+                    vertices_.push_back( facet[v] );
+                triangle[v] = inserted.first->second;
+            }
+
+            // Skip degenerate triangles
+            if ( triangle[0] == triangle[1] || triangle[1] == triangle[2] ||
+                 triangle[2] == triangle[0] )
+                continue;
+
+            int t = static_cast<int>( triangles_.size() );
+            std::array<int, 3> edges;
+            for ( int v = 0; v < 3; ++v )
+            {
+                int a = triangle[v];
+                int b = triangle[( v + 1 ) % 3];
+                auto inserted = edge_index.emplace(
+                    std::make_pair( std::min( a, b ), std::max( a, b ) ),
+                    static_cast<int>( edge_vertices_.size() ) );
+                int e = inserted.first->second;
+                if ( inserted.second )
+                {
+                    edge_vertices_.push_back( { a, b } );
+                    edge_triangles_.push_back( { t, -1 } );
+                }
+                else if ( edge_triangles_[e][1] < 0 )
+                    edge_triangles_[e][1] = t;
+                else
+                    throw std::runtime_error(
+                        "Error: STL surface has an edge shared by more than "
+                        "two triangles" );
+                edges[v] = e;
+            }
+            triangles_.push_back( triangle );
+            triangle_edges_.push_back( edges );
+        }
+
+        for ( const auto& neighbours : edge_triangles_ )
+            if ( neighbours[1] < 0 )
+                throw std::runtime_error( "Error: STL surface is not closed" );
+
+        // Triangle height ranges, sorted by the lowest vertex
+        min_z_ = std::numeric_limits<double>::max();
+        max_z_ = std::numeric_limits<double>::lowest();
+        for ( const auto& triangle : triangles_ )
+        {
+            double low = std::min( { vertices_[triangle[0]][2],
+                                     vertices_[triangle[1]][2],
+                                     vertices_[triangle[2]][2] } );
+            double high = std::max( { vertices_[triangle[0]][2],
+                                      vertices_[triangle[1]][2],
+                                      vertices_[triangle[2]][2] } );
+            triangle_min_z_.push_back( low );
+            triangle_max_z_.push_back( high );
+            min_z_ = std::min( min_z_, low );
+            max_z_ = std::max( max_z_, high );
+        }
+
+        order_.resize( triangles_.size() );
+        for ( std::size_t t = 0; t < order_.size(); ++t )
+            order_[t] = static_cast<int>( t );
+        std::sort( order_.begin(), order_.end(),
+                   [&]( const int a, const int b )
+                   { return triangle_min_z_[a] < triangle_min_z_[b]; } );
+    }
+
+    // Whether an edge has one vertex below and one at or above z
+    bool crosses( const int edge, const double z ) const
+    {
+        const auto& ends = edge_vertices_[edge];
+        return ( vertices_[ends[0]][2] < z ) != ( vertices_[ends[1]][2] < z );
+    }
+
+    // Edge of the triangle crossing z, other than the given one
+    int crossingEdge( const int triangle, const int other,
+                      const double z ) const
+    {
+        for ( int e : triangle_edges_[triangle] )
+            if ( e != other && crosses( e, z ) )
+                return e;
+        return -1;
+    }
+
+    // Point where an edge crosses z
+    Point crossingPoint( const int edge, const double z ) const
+    {
+        const Vertex& a = vertices_[edge_vertices_[edge][0]];
+        const Vertex& b = vertices_[edge_vertices_[edge][1]];
+        double t = ( z - a[2] ) / ( b[2] - a[2] );
+        return Point( a[0] + t * ( b[0] - a[0] ), a[1] + t * ( b[1] - a[1] ) );
+    }
+
+    std::vector<Vertex> vertices_;
+    std::vector<std::array<int, 3>> triangles_;
+    std::vector<std::array<int, 3>> triangle_edges_;
+    std::vector<std::array<int, 2>> edge_vertices_;
+    std::vector<std::array<int, 2>> edge_triangles_;
+
+    std::vector<double> triangle_min_z_;
+    std::vector<double> triangle_max_z_;
+    std::vector<int> order_;
+
+    double min_z_;
+    double max_z_;
+};
+
+} // namespace Finch
+
+#endif
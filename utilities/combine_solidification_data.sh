@@ -41,6 +41,12 @@ then
 elif [ ${nfields} == 5 ]
 then
    echo "x,y,z,tm,tl,cr" > ${output_filename}
+elif [ ${nfields} == 9 ]
+then
+   echo "x,y,z,tm,tl,cr,Gx,Gy,Gz,member" > ${output_filename}
+elif [ ${nfields} == 6 ]
+then
+   echo "x,y,z,tm,tl,cr,member" > ${output_filename}
 else
    echo "Unknown header format"
    exit 1
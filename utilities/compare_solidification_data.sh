@@ -0,0 +1,70 @@
+#!/bin/bash
+
+# Compare the solidification events of two runs of the same problem, e.g. a
+# run with sampling/interval > 1 against the per-step reference. Events are
+# matched by node and by their order at the node. Exits with 1 if the number
+# of events differs or any matched event exceeds the tolerances.
+
+time_tolerance=0.01
+rate_tolerance=0.05
+while getopts r:i:t:c: flag
+do
+    case "${flag}" in
+        r) reference_directory=${OPTARG};;
+        i) input_directory=${OPTARG};;
+        t) time_tolerance=${OPTARG};;
+        c) rate_tolerance=${OPTARG};;
+    esac
+done
+
+if [ -z "$reference_directory" ] || [ -z "$input_directory" ]
+then
+    echo "Usage: $0 -r <reference_directory> -i <input_directory>" \
+         "[-t <relative time tolerance>] [-c <relative rate tolerance>]"
+    exit 1
+fi
+echo "Comparing solidification data in: $input_directory";
+echo "Against the reference in: $reference_directory";
+
+# Events of one run sorted by node and melting time, with their order at the
+# node as the last field
+sorted_events()
+{
+    cat $1/*.csv | sort -t, -k1,1g -k2,2g -k3,3g -k4,4g |
+        awk -F, '{ key = $1 "," $2 "," $3; print $0 "," n[key]++ }'
+}
+
+awk -F, -v tt=${time_tolerance} -v rt=${rate_tolerance} '
+    function rel( a, b ) { d = a - b; if ( d < 0 ) d = -d;
+                           if ( b < 0 ) b = -b;
+                           return ( b > 0 ) ? d / b : d }
+    # Key: node and order of the event at the node
+    FNR == NR { key = $1 "," $2 "," $3 "," $NF; tm[key] = $4; tl[key] = $5;
+                cr[key] = $6; num_ref++; next }
+    {
+        key = $1 "," $2 "," $3 "," $NF;
+        num_in++;
+        if ( !( key in tm ) ) { extra++; next }
+        matched++;
+        e = rel( $4, tm[key] ); if ( e > max_tm ) max_tm = e;
+        if ( e > tt ) over++;
+        e = rel( $5, tl[key] ); if ( e > max_tl ) max_tl = e;
+        if ( e > tt ) over++;
+        e = rel( $6, cr[key] ); if ( e > max_cr ) max_cr = e;
+        if ( e > rt ) over++;
+        delete tm[key];
+    }
+    END {
+        missing = num_ref - matched;
+        printf "Events: %d (reference %d), missing %d, extra %d\n",
+               num_in, num_ref, missing, extra;
+        printf "Maximum relative difference: tm %g, tl %g, cr %g\n",
+               max_tm, max_tl, max_cr;
+        if ( missing > 0 || extra > 0 || over > 0 )
+        {
+            printf "Differences exceed the tolerances (time %g, rate %g)\n",
+                   tt, rt;
+            exit 1;
+        }
+        print "Events agree within the tolerances";
+    }' <(sorted_events ${reference_directory}) <(sorted_events ${input_directory})